@@ -1,10 +1,97 @@
 namespace yarp roboticslab
 
+struct BoundingBox
+{
+    1: i32 x;
+    2: i32 y;
+    3: i32 width;
+    4: i32 height;
+}
+
+struct Detection
+{
+    1: i32 id = -1;
+    2: double x;
+    3: double y;
+    4: double z;
+    5: double confidence = 1.0;
+    6: BoundingBox box;
+}
+
+struct DetectionList
+{
+    1: i32 version = 1;
+    2: double timestamp;
+    3: list<Detection> detections;
+}
+
+struct RegionOfInterest
+{
+    1: double timestamp;
+    2: i32 targetId = -1;
+    3: BoundingBox box;
+}
+
+struct HeadStatistics
+{
+    1: i64 receivedFrames;
+    2: i64 droppedFrames;
+    3: i64 supersededFrames;
+    4: i64 processedFrames;
+    5: i64 issuedCommands;
+    6: i64 coalescedCommands;
+    7: i64 suppressedCommands;
+}
+
+struct HeadState
+{
+    1: double panPosition;
+    2: double tiltPosition;
+    3: double panVelocity;
+    4: double tiltVelocity;
+    5: double timestamp;
+    6: bool targetOutOfReach;
+}
+
+struct TrackedTarget
+{
+    1: i32 id;
+    2: double pan;
+    3: double tilt;
+    4: double panVelocity;
+    5: double tiltVelocity;
+    6: double confidence;
+    7: double lastSeen;
+    8: bool followed;
+}
+
+enum ActionStatus
+{
+    STARTED,
+    FINISHED,
+    PREEMPTED,
+    FAILED
+}
+
+struct ActionEvent
+{
+    1: double timestamp;
+    2: string action;
+    3: string part;
+    4: ActionStatus status;
+}
+
 service FollowMeHeadCommands
 {
     oneway void enableFollowing();
     oneway void disableFollowing();
     double getOrientationAngle();
+    HeadState getHeadState();
+    HeadStatistics getStatistics();
+    list<TrackedTarget> listTargets();
+    bool lockTarget(1: i32 id);
+    bool unlockTarget();
+    bool switchTarget();
     bool stop();
 }
 
@@ -15,5 +102,8 @@ service FollowMeArmCommands
     oneway void doSignalRight();
     oneway void enableArmSwinging();
     oneway void disableArmSwinging();
+    bool setSwingParameters(1: double amplitude, 2: double frequency);
+    bool setSpeedFactor(1: double factor);
+    bool playGesture(1: string name);
     bool stop();
 }
@@ -0,0 +1,219 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "BlendedTrajectory.hpp"
+
+#include <cmath> // std::abs
+
+#include <algorithm> // std::max, std::min
+
+using namespace roboticslab;
+
+constexpr auto MIN_SEGMENT_DURATION = 0.05; // [s]
+constexpr auto STRETCH_FACTOR = 1.25; // segment slowdown per attempt to fit the blends
+constexpr auto MAX_STRETCHES = 100;
+constexpr auto MAX_ITERATIONS = 20; // sliding a corner until its blend fits
+
+namespace
+{
+    void sampleBlend(double s, double duration, double p0, double v0, double v1, double & p, double & v)
+    {
+        auto a = (v1 - v0) / duration;
+        p = p0 + v0 * s + 0.5 * a * s * s;
+        v = v0 + a * s;
+    }
+}
+
+void BlendedTrajectory::reset(double timestamp, const vector_t & position, const vector_t & velocity)
+{
+    auto & c = corners[0];
+    c.velocityIn = velocity;
+    c.velocityOut.fill(0.0);
+    c.blend = minBlend(c.velocityIn, c.velocityOut);
+
+    // the blend begins right now, its corner lies where the current velocity would lead to
+    for (auto j = 0U; j < MAX_JOINTS; j++)
+    {
+        c.position[j] = position[j] + velocity[j] * c.blend / 2.0;
+    }
+
+    c.time = timestamp + c.blend / 2.0;
+    count = 1;
+}
+
+bool BlendedTrajectory::canAppend(double timestamp) const
+{
+    if (count == MAX_CORNERS)
+    {
+        return false;
+    }
+
+    const auto & last = corners[count - 1];
+
+    // the final blend may be reshaped as long as it has not begun yet, a resting trajectory starts over
+    return timestamp <= last.time - last.blend / 2.0 || (count == 1 && isFinished(timestamp));
+}
+
+bool BlendedTrajectory::append(double timestamp, const vector_t & position, double speed)
+{
+    if (!canAppend(timestamp))
+    {
+        return false;
+    }
+
+    auto & previous = corners[count - 1];
+    auto & next = corners[count];
+
+    // The blend around the previous corner may not begin before the one preceding it ends, nor in the
+    // past. If it can't fit there, its center slides further along the incoming segment (this is where
+    // a committed motion turns around at the acceleration limit). The first corner has no preceding
+    // blend, it begins right away at the current state.
+    auto isLaunch = count == 1;
+
+    vector_t velocityIn = previous.velocityIn;
+    vector_t rest {};
+    double earliest;
+
+    if (isLaunch && isFinished(timestamp))
+    {
+        velocityIn.fill(0.0);
+        earliest = timestamp;
+    }
+    else if (isLaunch)
+    {
+        earliest = previous.time - previous.blend / 2.0;
+    }
+    else
+    {
+        earliest = std::max(timestamp, corners[count - 2].time + corners[count - 2].blend / 2.0);
+    }
+
+    auto nominal = isLaunch ? earliest : previous.time;
+    auto stretch = 1.0;
+
+    // too short segments can't fit blends within the acceleration limit, slow them down until they do
+    for (auto attempt = 0; attempt < MAX_STRETCHES; attempt++, stretch *= STRETCH_FACTOR)
+    {
+        vector_t corner, velocityOut;
+        double center = nominal, duration = 0.0, requiredIn = 0.0, requiredOut = 0.0;
+        auto blend = isLaunch ? blendTime : 0.0;
+        auto isFitting = false;
+
+        for (auto iteration = 0; iteration < MAX_ITERATIONS && !isFitting; iteration++)
+        {
+            center = std::max(nominal, earliest + blend / 2.0);
+
+            for (auto j = 0U; j < MAX_JOINTS; j++)
+            {
+                corner[j] = previous.position[j] + velocityIn[j] * (center - previous.time);
+            }
+
+            // all joints arrive together, the slowest one sets the pace
+            duration = MIN_SEGMENT_DURATION;
+
+            for (auto j = 0U; j < MAX_JOINTS; j++)
+            {
+                duration = std::max(duration, std::abs(position[j] - corner[j]) / std::min(speed, maxVelocities[j]));
+            }
+
+            duration *= stretch;
+
+            for (auto j = 0U; j < MAX_JOINTS; j++)
+            {
+                velocityOut[j] = (position[j] - corner[j]) / duration;
+            }
+
+            requiredIn = minBlend(velocityIn, velocityOut);
+            requiredOut = minBlend(velocityOut, rest);
+            isFitting = requiredIn <= blend;
+            blend = std::max(blend, requiredIn);
+        }
+
+        if (!isFitting || (requiredIn + requiredOut) / 2.0 > duration)
+        {
+            continue;
+        }
+
+        previous.position = corner;
+        previous.velocityIn = velocityIn;
+        previous.velocityOut = velocityOut;
+        previous.time = center;
+        previous.blend = std::min({std::max(blendTime, requiredIn), 2.0 * (center - earliest), 2.0 * duration - requiredOut});
+
+        next.position = position;
+        next.velocityIn = velocityOut;
+        next.velocityOut.fill(0.0);
+        next.time = center + duration;
+        next.blend = std::min(std::max(blendTime, requiredOut), 2.0 * duration - previous.blend);
+        count++;
+        return true;
+    }
+
+    return false;
+}
+
+void BlendedTrajectory::evaluate(double timestamp, vector_t & position, vector_t & velocity)
+{
+    while (count > 1 && timestamp >= corners[1].time)
+    {
+        for (auto i = 1U; i < count; i++)
+        {
+            corners[i - 1] = corners[i];
+        }
+
+        count--;
+    }
+
+    const auto & a = corners[0];
+
+    if (timestamp < a.time + a.blend / 2.0)
+    {
+        auto s = timestamp - (a.time - a.blend / 2.0);
+
+        for (auto j = 0U; j < MAX_JOINTS; j++)
+        {
+            if (s < 0.0)
+            {
+                // still approaching a blend that begins later, or resting until then
+                position[j] = a.position[j] + a.velocityIn[j] * (timestamp - a.time);
+                velocity[j] = a.velocityIn[j];
+            }
+            else
+            {
+                auto start = a.position[j] - a.velocityIn[j] * a.blend / 2.0;
+                sampleBlend(s, a.blend, start, a.velocityIn[j], a.velocityOut[j], position[j], velocity[j]);
+            }
+        }
+    }
+    else if (count > 1 && timestamp >= corners[1].time - corners[1].blend / 2.0)
+    {
+        const auto & b = corners[1];
+        auto s = timestamp - (b.time - b.blend / 2.0);
+
+        for (auto j = 0U; j < MAX_JOINTS; j++)
+        {
+            auto start = b.position[j] - b.velocityIn[j] * b.blend / 2.0;
+            sampleBlend(s, b.blend, start, b.velocityIn[j], b.velocityOut[j], position[j], velocity[j]);
+        }
+    }
+    else
+    {
+        // cruising along a linear segment, or resting at the last via point
+        for (auto j = 0U; j < MAX_JOINTS; j++)
+        {
+            position[j] = a.position[j] + a.velocityOut[j] * (timestamp - a.time);
+            velocity[j] = a.velocityOut[j];
+        }
+    }
+}
+
+double BlendedTrajectory::minBlend(const vector_t & velocityIn, const vector_t & velocityOut) const
+{
+    double change = 0.0;
+
+    for (auto j = 0U; j < MAX_JOINTS; j++)
+    {
+        change = std::max(change, std::abs(velocityOut[j] - velocityIn[j]));
+    }
+
+    return change / acceleration;
+}
@@ -0,0 +1,91 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __BLENDED_TRAJECTORY_HPP__
+#define __BLENDED_TRAJECTORY_HPP__
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeArmExecution
+ * @brief Joint trajectory through via points, linear segments with parabolic blends.
+ *
+ * Via points are appended on the fly while the trajectory is being evaluated. Each
+ * corner is rounded off by a constant-acceleration blend centered at the via point,
+ * hence the motion does not stop there. The trajectory comes to rest exactly at the
+ * last via point unless another one is appended before its final blend begins.
+ * Blends never exceed the acceleration limit, segments are slowed down instead
+ * whenever they are too short to fit them.
+ */
+class BlendedTrajectory
+{
+public:
+    static constexpr std::size_t MAX_JOINTS = 12;
+
+    using vector_t = std::array<double, MAX_JOINTS>;
+
+    BlendedTrajectory(double blendTime = 0.2, double acceleration = 30.0)
+        : blendTime(blendTime), acceleration(acceleration)
+    { maxVelocities.fill(std::numeric_limits<double>::infinity()); }
+
+    //! Per-joint velocity limits [deg/s], segments are slowed down to honor them.
+    void setMaxVelocities(const vector_t & velocities)
+    { maxVelocities = velocities; }
+
+    //! Start over from the given state, coming to rest as fast as the acceleration limit allows.
+    void reset(double timestamp, const vector_t & position, const vector_t & velocity = {});
+
+    //! Whether a via point can still be appended without altering a blend in progress.
+    bool canAppend(double timestamp) const;
+
+    //! Append a via point to be traversed at the given cruise speed [deg/s], false if it does not fit.
+    bool append(double timestamp, const vector_t & position, double speed);
+
+    //! Sample the trajectory, drops via points left behind.
+    void evaluate(double timestamp, vector_t & position, vector_t & velocity);
+
+    //! Whether the trajectory came to rest at the last via point.
+    bool isFinished(double timestamp) const
+    { return count == 1 && timestamp >= corners[0].time + corners[0].blend / 2.0; }
+
+    //! Last appended via point.
+    const vector_t & getLast() const
+    { return corners[count - 1].position; }
+
+    //! Time at which the last appended via point is reached, or passed by.
+    double getLastTime() const
+    { return corners[count - 1].time; }
+
+    //! Time at which the trajectory comes to rest unless more via points are appended.
+    double getFinishTime() const
+    { return corners[count - 1].time + corners[count - 1].blend / 2.0; }
+
+private:
+    struct corner_t
+    {
+        vector_t position; // [deg]
+        vector_t velocityIn; // [deg/s]
+        vector_t velocityOut; // [deg/s]
+        double time; // [s], center of the blend
+        double blend; // [s], duration of the blend
+    };
+
+    static constexpr std::size_t MAX_CORNERS = 4;
+
+    double minBlend(const vector_t & velocityIn, const vector_t & velocityOut) const;
+
+    double blendTime;
+    double acceleration;
+
+    vector_t maxVelocities;
+    std::array<corner_t, MAX_CORNERS> corners;
+    std::size_t count {0};
+};
+
+} // namespace roboticslab
+
+#endif // __BLENDED_TRAJECTORY_HPP__
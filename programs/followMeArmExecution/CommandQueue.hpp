@@ -0,0 +1,99 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __COMMAND_QUEUE_HPP__
+#define __COMMAND_QUEUE_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeArmExecution
+ * @brief Bounded lock-free queue, many producers and a single consumer.
+ *
+ * Each cell carries a sequence number that tells producers and the consumer
+ * whether it is free or ready to be read, hence neither side ever blocks. Items
+ * are copied in and out, storage is preallocated.
+ */
+template <typename T, std::size_t N>
+class CommandQueue
+{
+    static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    CommandQueue()
+    {
+        for (auto i = 0U; i < N; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //! Enqueue an item from any thread, returns false if the queue is full.
+    bool push(const T & value)
+    {
+        auto position = tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto & cell = cells[position & (N - 1)];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (diff == 0)
+            {
+                // the cell is free, claim it unless another producer was faster
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // not consumed yet
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! Dequeue an item, only to be called from the consumer thread.
+    bool pop(T & value)
+    {
+        auto & cell = cells[head & (N - 1)];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+
+        if (sequence != head + 1)
+        {
+            return false; // empty, or a producer did not finish writing yet
+        }
+
+        value = cell.value;
+        cell.sequence.store(head + N, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+private:
+    struct cell_t
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::array<cell_t, N> cells;
+    alignas(64) std::atomic<std::size_t> tail {0};
+    alignas(64) std::size_t head {0};
+};
+
+} // namespace roboticslab
+
+#endif // __COMMAND_QUEUE_HPP__
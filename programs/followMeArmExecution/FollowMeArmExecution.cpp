@@ -2,11 +2,17 @@
 
 #include "FollowMeArmExecution.hpp"
 
+#include <cmath> // std::abs, std::sqrt
+
+#include <algorithm> // std::copy, std::find, std::max, std::min
+#include <limits>
 #include <string>
 #include <vector>
 
 #include <yarp/os/LogStream.h>
 #include <yarp/os/Property.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
 
 using namespace roboticslab;
 
@@ -14,13 +20,68 @@ constexpr auto DEFAULT_ROBOT = "/teo";
 constexpr auto DEFAULT_PREFIX = "/followMeArmExecution";
 constexpr auto DEFAULT_REF_SPEED = 30.0;
 constexpr auto DEFAULT_REF_ACCELERATION = 30.0;
+constexpr auto DEFAULT_GESTURES = "gestures.ini";
+constexpr auto DEFAULT_PERIOD = 0.005; // [s]
+constexpr auto MOTION_DONE_CHECK_PERIOD = 0.05; // [s]
+constexpr auto DEFAULT_MODE = "position";
+constexpr auto DEFAULT_BLEND_TIME = 0.2; // [s]
+constexpr auto DEFAULT_SWING_AMPLITUDE = 20.0; // [deg]
+constexpr auto DEFAULT_SWING_FREQUENCY = 0.9; // [Hz]
+constexpr auto MAX_SWING_AMPLITUDE = 45.0; // [deg]
+constexpr auto MAX_SWING_FREQUENCY = 2.0; // [Hz]
+constexpr auto MIN_SWING_TRANSITION = 0.5; // [s]
+constexpr auto MAX_GAIT_LATENCY = 0.2; // [s]
+constexpr auto MAX_SPEED_FACTOR = 3.0;
+
+namespace
+{
+    // trapezoidal velocity profile, triangular if the cruise speed is never reached
+    double predictDuration(double distance, double speed, double acceleration)
+    {
+        distance = std::abs(distance);
+
+        if (distance * acceleration >= speed * speed)
+        {
+            return distance / speed + speed / acceleration;
+        }
+
+        return 2.0 * std::sqrt(distance / acceleration);
+    }
+
+    // cruise speed of the trapezoidal velocity profile that covers the distance in the given time
+    double synchronizeSpeed(double distance, double duration, double acceleration)
+    {
+        auto discriminant = acceleration * acceleration * duration * duration - 4.0 * acceleration * distance;
+        return (acceleration * duration - std::sqrt(std::max(discriminant, 0.0))) / 2.0;
+    }
+}
+
+FollowMeArmExecution::FollowMeArmExecution()
+    : yarp::os::PeriodicThread(DEFAULT_PERIOD)
+{
+    for (auto i = 0U; i < NUM_ARMS; i++)
+    {
+        auto & channel = channels[i];
+        channel.name = i == 0 ? "left" : "right";
+        channel.index = i;
 
-constexpr FollowMeArmExecution::setpoints_arm_t armZeros {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        for (auto j = 0U; j < NUM_ARM_JOINTS; j++)
+        {
+            channel.joints[j] = i * NUM_ARM_JOINTS + j;
+        }
+    }
+}
 
 bool FollowMeArmExecution::configure(yarp::os::ResourceFinder & rf)
 {
     auto robot = rf.check("robot", yarp::os::Value(DEFAULT_ROBOT), "remote robot port prefix").asString();
-    auto armSpeed = rf.check("armSpeed", yarp::os::Value(DEFAULT_REF_SPEED), "arm speed").asFloat64();
+    auto armSpeed = rf.check("armSpeed", yarp::os::Value(DEFAULT_REF_SPEED), "default arm speed, scales all gestures [deg/s]").asFloat64();
+    auto gesturesFile = rf.check("gestures", yarp::os::Value(DEFAULT_GESTURES), "gesture library file").asString();
+    auto period = rf.check("period", yarp::os::Value(DEFAULT_PERIOD), "sequencer thread period [s]").asFloat64();
+    auto mode = rf.check("mode", yarp::os::Value(DEFAULT_MODE), "control mode (position, direct)").asString();
+    auto blendTime = rf.check("blendTime", yarp::os::Value(DEFAULT_BLEND_TIME), "min duration of blends around via points in direct mode [s]").asFloat64();
+    swingAmplitude = rf.check("swingAmplitude", yarp::os::Value(DEFAULT_SWING_AMPLITUDE), "arm swing amplitude [deg]").asFloat64();
+    swingFrequency = rf.check("swingFrequency", yarp::os::Value(DEFAULT_SWING_FREQUENCY), "arm swing frequency without gait signal [Hz]").asFloat64();
 
     if (rf.check("help"))
     {
@@ -28,6 +89,68 @@ bool FollowMeArmExecution::configure(yarp::os::ResourceFinder & rf)
         yInfo("\t--help (this help)\t--from [file.ini]\t--context [path]");
         yInfo("\t--robot: %s [%s]", robot.c_str(), DEFAULT_ROBOT);
         yInfo("\t--armSpeed: %f [%f]", armSpeed, DEFAULT_REF_SPEED);
+        yInfo("\t--gestures: %s [%s]", gesturesFile.c_str(), DEFAULT_GESTURES);
+        yInfo("\t--period: %f [%f]", period, DEFAULT_PERIOD);
+        yInfo("\t--mode: %s [%s]", mode.c_str(), DEFAULT_MODE);
+        yInfo("\t--blendTime: %f [%f]", blendTime, DEFAULT_BLEND_TIME);
+        yInfo("\t--swingAmplitude: %f [%f]", swingAmplitude, DEFAULT_SWING_AMPLITUDE);
+        yInfo("\t--swingFrequency: %f [%f]", swingFrequency, DEFAULT_SWING_FREQUENCY);
+        return false;
+    }
+
+    if (mode == "position")
+    {
+        controlMode = control_mode::POSITION;
+    }
+    else if (mode == "direct")
+    {
+        controlMode = control_mode::DIRECT;
+    }
+    else
+    {
+        yError() << "Unsupported control mode, please use '--mode position' or '--mode direct', got:" << mode;
+        return false;
+    }
+
+    if (blendTime <= 0.0)
+    {
+        yError() << "Blend time must be positive, got:" << blendTime;
+        return false;
+    }
+
+    for (auto & channel : channels)
+    {
+        channel.trajectory = BlendedTrajectory(blendTime, DEFAULT_REF_ACCELERATION);
+    }
+
+    if (armSpeed <= 0.0 || armSpeed > MAX_SPEED_FACTOR * DEFAULT_REF_SPEED)
+    {
+        yError() << "Arm speed must lie in (0," << MAX_SPEED_FACTOR * DEFAULT_REF_SPEED << "] deg/s, got:" << armSpeed;
+        return false;
+    }
+
+    speedFactor = armSpeed / DEFAULT_REF_SPEED;
+
+    if (swingAmplitude < 0.0 || swingAmplitude > MAX_SWING_AMPLITUDE)
+    {
+        yError() << "Swing amplitude must lie in [0," << MAX_SWING_AMPLITUDE << "] degrees, got:" << swingAmplitude;
+        return false;
+    }
+
+    if (swingFrequency <= 0.0 || swingFrequency > MAX_SWING_FREQUENCY)
+    {
+        yError() << "Swing frequency must lie in (0," << MAX_SWING_FREQUENCY << "] Hz, got:" << swingFrequency;
+        return false;
+    }
+
+    if (!loadGestures(rf.findFileByName(gesturesFile)))
+    {
+        return false;
+    }
+
+    if (period <= 0.0 || !yarp::os::PeriodicThread::setPeriod(period))
+    {
+        yError() << "Invalid sequencer thread period:" << period;
         return false;
     }
 
@@ -58,19 +181,61 @@ bool FollowMeArmExecution::configure(yarp::os::ResourceFinder & rf)
         return false;
     }
 
-    if (!armsDevice.view(armsIControlMode) || !armsDevice.view(armsIPositionControl))
+    if (!armsDevice.view(armsIControlLimits) || !armsDevice.view(armsIControlMode) || !armsDevice.view(armsIEncoders) ||
+        !armsDevice.view(armsIPositionControl) || !armsDevice.view(armsIPositionDirect))
     {
         yError() << "Failed to view arms device interfaces";
         return false;
     }
 
-    if (!armsIControlMode->setControlModes(std::vector(axesNames.size(), VOCAB_CM_POSITION).data()))
+    for (auto i = 0U; i < maxVelocities.size(); i++)
+    {
+        double minVelocity;
+
+        if (!armsIControlLimits->getVelLimits(i, &minVelocity, &maxVelocities[i]))
+        {
+            yError() << "Failed to retrieve velocity limits of arm joint" << i;
+            return false;
+        }
+
+        if (maxVelocities[i] <= 0.0)
+        {
+            maxVelocities[i] = std::numeric_limits<double>::infinity(); // not enforced by the device
+        }
+    }
+
+    for (auto & channel : channels)
+    {
+        channel.trajectory.setMaxVelocities(maxVelocities);
+    }
+
+    oscillator.setMaxVelocities(maxVelocities);
+
+    if (controlMode == control_mode::DIRECT)
+    {
+        if (!armsIEncoders->getEncoders(reference.data()))
+        {
+            yError() << "Failed to read initial arm encoders";
+            return false;
+        }
+
+        for (auto & channel : channels)
+        {
+            channel.trajectory.reset(yarp::os::Time::now(), reference);
+        }
+    }
+
+    auto controlModeVocab = controlMode == control_mode::DIRECT ? VOCAB_CM_POSITION_DIRECT : VOCAB_CM_POSITION;
+
+    if (!armsIControlMode->setControlModes(std::vector(axesNames.size(), controlModeVocab).data()))
     {
-        yError() << "Failed to set position control mode for arms";
+        yError() << "Failed to set control mode for arms";
         return false;
     }
 
-    if (!armsIPositionControl->setRefSpeeds(std::vector(axesNames.size(), DEFAULT_REF_SPEED).data()))
+    speeds.fill(DEFAULT_REF_SPEED);
+
+    if (!armsIPositionControl->setRefSpeeds(speeds.data()))
     {
         yError() << "Failed to set reference speeds for arms";
         return false;
@@ -88,6 +253,26 @@ bool FollowMeArmExecution::configure(yarp::os::ResourceFinder & rf)
         return false;
     }
 
+    gaitPort.setStrict(); // every phase sample counts
+
+    if (!gaitPort.open(DEFAULT_PREFIX + std::string("/gait:i")))
+    {
+        yError() << "Failed to open gait port" << gaitPort.getName();
+        return false;
+    }
+
+    if (!eventPort.open(DEFAULT_PREFIX + std::string("/events:o")))
+    {
+        yError() << "Failed to open event port" << eventPort.getName();
+        return false;
+    }
+
+    if (!yarp::os::PeriodicThread::start())
+    {
+        yError() << "Failed to start sequencer thread";
+        return false;
+    }
+
     yarp::os::Wire::yarp().attachAsServer(serverPort);
     return true;
 }
@@ -95,119 +280,819 @@ bool FollowMeArmExecution::configure(yarp::os::ResourceFinder & rf)
 bool FollowMeArmExecution::interruptModule()
 {
     serverPort.interrupt();
-    return stop();
+    gaitPort.interrupt();
+    eventPort.interrupt();
+    yarp::os::PeriodicThread::stop();
+    return haltArms(); // no one is left to process the command queue
 }
 
 bool FollowMeArmExecution::close()
 {
+    yarp::os::PeriodicThread::stop();
     serverPort.close();
+    gaitPort.close();
+    eventPort.close();
     armsDevice.close();
     return true;
 }
 
 double FollowMeArmExecution::getPeriod()
 {
-    return 0.1; // [s]
+    return 0.02; // [s], also the latency of action events
 }
 
 bool FollowMeArmExecution::updateModule()
 {
-    bool isMotionDone = checkMotionDone();
-    std::unique_lock lock(actionMutex);
+    int left = channels[0].activeGesture;
+    int right = channels[1].activeGesture;
+    yDebugThrottle(1.0) << "Current action, left arm:" << (left >= 0 ? gestures[left].name.c_str() : "none")
+                        << "| right arm:" << (right >= 0 ? gestures[right].name.c_str() : "none");
 
-    yDebugThrottle(1.0) << "Current action:" << getStateDescription(currentState);
+    yDebugThrottle(5.0) << "Waypoints sent:" << sentWaypoints << "| motion state queries:" << motionQueries;
 
-    if (hasNewSetpoints || (isMotionDone && !currentSetpoints.empty()))
+    pending_event_t pending;
+
+    while (events.pop(pending))
     {
-        auto [leftArm, rightArm] = currentSetpoints.front();
-        currentSetpoints.pop_front();
-        hasNewSetpoints = false;
-        lock.unlock();
+        auto & event = eventPort.prepare();
+        event.timestamp = pending.timestamp;
+        event.action = pending.action;
+        event.part = pending.part;
+        event.status = pending.status;
+        eventPort.writeStrict(); // none may be lost, clients count them
+    }
+
+    return true;
+}
+
+void FollowMeArmExecution::run()
+{
+    auto now = yarp::os::Time::now();
+    processCommands();
+    readGait(now);
 
-        std::vector<double> values;
-        values.insert(values.end(), leftArm.begin(), leftArm.end());
-        values.insert(values.end(), rightArm.begin(), rightArm.end());
+    for (auto & channel : channels)
+    {
+        updateExecutions(channel, now, 0.0);
 
-        if (!armsIPositionControl->positionMove(values.data()))
+        if (!swingArm(channel, now))
         {
-            yWarning() << "Failed to send new setpoints to arms";
+            if (controlMode == control_mode::DIRECT)
+            {
+                streamGestures(channel, now);
+            }
+            else
+            {
+                sequenceGestures(channel, now);
+            }
         }
+
+        channel.activeGesture = channel.currentGesture ? static_cast<int>(channel.currentGesture - gestures.data()) : -1;
+    }
+}
+
+void FollowMeArmExecution::sequenceGestures(channel_t & channel, double now)
+{
+    channel.hasStopRequest = false; // the boards were told to stop right away
+
+    if (!channel.currentGesture)
+    {
+        return; // just stay calm
     }
-    else if (!hasNewSetpoints && isMotionDone && currentSetpoints.empty())
+
+    if (!channel.hasNewSetpoints)
     {
-        // motion done and no more points to send
+        if (now < channel.arrivalTime + channel.currentDwell)
+        {
+            return; // still moving or dwelling
+        }
 
-        switch (currentState)
+        if (channel.nextWaypoint == channel.currentGesture->waypointCount)
         {
-        case state::GREET:
-        case state::SIGNAL_LEFT:
-        case state::SIGNAL_RIGHT:
-        case state::SWING:
-            lock.unlock(); // avoid deadlock due to the next call
-            enableArmSwinging(); // send moar points!
-            break;
-        case state::HOMING:
-            currentState = state::REST;
+            // gesture done, loops go on unless another action is waiting
+            if (channel.currentGesture->loop && channel.pendingCount == 0)
+            {
+                channel.nextWaypoint = 0;
+                beginExecution(channel, *channel.currentGesture, now, true);
+            }
+            else
+            {
+                // the prediction might be off, make sure the arm actually got there
+                if (now < channel.nextMotionCheck)
+                {
+                    return;
+                }
+
+                if (!checkMotionDone(channel))
+                {
+                    channel.nextMotionCheck = now + MOTION_DONE_CHECK_PERIOD;
+                    return;
+                }
+
+                if (const auto * next = nextGesture(channel))
+                {
+                    channel.currentGesture = next;
+                    channel.nextWaypoint = 0;
+                    yInfo() << "Next action:" << next->name << "on the" << channel.name << "arm";
+
+                    endExecution(channel, now, ActionStatus::FINISHED);
+
+                    if (next == &gestures[swingGesture])
+                    {
+                        return; // the oscillator takes over
+                    }
+
+                    beginExecution(channel, *next, now);
+                }
+                else
+                {
+                    channel.currentGesture = nullptr;
+                    endExecution(channel, now, ActionStatus::FINISHED);
+                    return;
+                }
+            }
+        }
+    }
+    else
+    {
+        if (!readEncoders(channel, commandedPositions))
+        {
+            // interrupted motion, predict from where the arm is now
+            yWarning() << "Failed to read" << channel.name << "arm encoders";
+        }
+
+        beginExecution(channel, *channel.currentGesture, now);
+    }
+
+    const auto & gesture = *channel.currentGesture;
+    const auto & waypoint = gesture.waypoints[channel.nextWaypoint++];
+    auto speed = (waypoint.speed > 0.0 ? waypoint.speed : DEFAULT_REF_SPEED) * speedFactor;
+
+    channel.hasNewSetpoints = false;
+    channel.currentDwell = waypoint.dwell;
+    double peakVelocity;
+    channel.arrivalTime = now + predictArrival(channel, gesture, waypoint, speed, peakVelocity);
+    channel.nextMotionCheck = channel.arrivalTime;
+
+    if (!sendWaypoint(channel, gesture, waypoint))
+    {
+        // give up on this gesture and whatever it chains to, queued ones still get their turn
+        endExecution(channel, now, ActionStatus::FAILED);
+
+        if (channel.pendingCount != 0)
+        {
+            assignGesture(channel, *nextGesture(channel));
+        }
+        else
+        {
+            channel.currentGesture = nullptr;
+        }
+    }
+
+    updateExecutions(channel, now, peakVelocity); // as planned, the boards are not queried
+}
+
+void FollowMeArmExecution::streamGestures(channel_t & channel, double now)
+{
+    auto & trajectory = channel.trajectory;
+
+    if (channel.hasStopRequest || channel.hasNewSetpoints)
+    {
+        // ramp down from the current motion at the acceleration limit, a new gesture blends right into it
+        BlendedTrajectory::vector_t position, velocity;
+        trajectory.evaluate(now, position, velocity);
+        trajectory.reset(now, position, velocity);
+        channel.hasStopRequest = false;
+        channel.isDwellPending = false;
+
+        if (channel.hasNewSetpoints)
+        {
+            channel.hasNewSetpoints = false;
+            beginExecution(channel, *channel.currentGesture, now);
+        }
+        else
+        {
+            endExecution(channel, now, ActionStatus::PREEMPTED);
+        }
+    }
+
+    // keep feeding via points ahead of time so that they are blended together
+    while (channel.currentGesture && channel.currentGesture != &gestures[swingGesture] && trajectory.canAppend(now))
+    {
+        if (channel.isDwellPending)
+        {
+            if (now < channel.dwellDeadline)
+            {
+                break;
+            }
+
+            channel.isDwellPending = false;
+        }
+
+        if (channel.nextWaypoint == channel.currentGesture->waypointCount)
+        {
+            const gesture_t * next = nullptr;
+
+            if (channel.currentGesture->loop && channel.pendingCount == 0)
+            {
+                channel.nextWaypoint = 0;
+                beginExecution(channel, *channel.currentGesture, trajectory.getLastTime(), true);
+            }
+            else if ((next = nextGesture(channel)))
+            {
+                channel.currentGesture = next;
+                channel.nextWaypoint = 0;
+                yInfo() << "Next action:" << next->name << "on the" << channel.name << "arm";
+
+                if (next == &gestures[swingGesture])
+                {
+                    // the oscillator takes over once the arm comes to rest
+                    endExecution(channel, trajectory.getFinishTime(), ActionStatus::FINISHED);
+                    break;
+                }
+
+                endExecution(channel, trajectory.getLastTime(), ActionStatus::FINISHED);
+                beginExecution(channel, *next, trajectory.getLastTime());
+            }
+            else
+            {
+                channel.currentGesture = nullptr;
+                endExecution(channel, trajectory.getFinishTime(), ActionStatus::FINISHED);
+                break;
+            }
+        }
+
+        const auto & gesture = *channel.currentGesture;
+        const auto & waypoint = gesture.waypoints[channel.nextWaypoint];
+        auto offset = gesture.armOffsets[channel.index];
+        auto target = trajectory.getLast();
+
+        for (auto i = 0U; i < NUM_ARM_JOINTS; i++)
+        {
+            target[gesture.joints[offset + i]] = waypoint.positions[offset + i];
+        }
+
+        if (!trajectory.append(now, target, (waypoint.speed > 0.0 ? waypoint.speed : DEFAULT_REF_SPEED) * speedFactor))
+        {
+            break; // retried once the arm comes to rest
+        }
+
+        channel.nextWaypoint++;
+        sentWaypoints++;
+
+        if (waypoint.dwell > 0.0)
+        {
+            // come to rest here, no blending with the next via point
+            channel.isDwellPending = true;
+            channel.dwellDeadline = trajectory.getFinishTime() + waypoint.dwell;
             break;
-        case state::REST:
-            // just stay calm
+        }
+    }
+
+    BlendedTrajectory::vector_t position, velocity;
+    trajectory.evaluate(now, position, velocity);
+    streamReference(channel, now, position, velocity);
+}
+
+void FollowMeArmExecution::streamReference(channel_t & channel, double now, const BlendedTrajectory::vector_t & position,
+                                           const BlendedTrajectory::vector_t & velocity)
+{
+    double peakVelocity = 0.0;
+
+    for (auto j : channel.joints)
+    {
+        reference[j] = position[j];
+        peakVelocity = std::max(peakVelocity, std::abs(velocity[j]));
+    }
+
+    // arm joints are contiguous
+    if (!armsIPositionDirect->setPositions(NUM_ARM_JOINTS, channel.joints.data(), reference.data() + channel.joints[0]))
+    {
+        yWarningThrottle(1.0) << "Failed to stream setpoints to" << channel.name << "arm";
+    }
+
+    updateExecutions(channel, now, peakVelocity);
+}
+
+void FollowMeArmExecution::beginExecution(channel_t & channel, const gesture_t & gesture, double start, bool isRepeat)
+{
+    // whatever was still going on got cut short, unless the gesture just loops over
+    endExecution(channel, start, ActionStatus::PREEMPTED);
+
+    if (isRepeat && channel.executionCount != 0)
+    {
+        channel.executions[channel.executionCount - 1].isContinued = true;
+    }
+
+    if (channel.executionCount == channel.executions.size())
+    {
+        updateExecutions(channel, channel.executions[0].end, 0.0); // make room, report right away
+    }
+
+    channel.executions[channel.executionCount++] = {&gesture, start, -1.0, 0.0, isRepeat, false, false,
+                                                    ActionStatus::FINISHED};
+}
+
+void FollowMeArmExecution::endExecution(channel_t & channel, double end, ActionStatus outcome)
+{
+    if (channel.executionCount != 0 && channel.executions[channel.executionCount - 1].end < 0.0)
+    {
+        channel.executions[channel.executionCount - 1].end = end;
+        channel.executions[channel.executionCount - 1].outcome = outcome;
+    }
+}
+
+void FollowMeArmExecution::updateExecutions(channel_t & channel, double now, double velocity)
+{
+    auto & executions = channel.executions;
+
+    while (channel.executionCount != 0 && now >= executions[0].start)
+    {
+        auto & e = executions[0];
+
+        if (!e.hasStarted)
+        {
+            e.hasStarted = true;
+
+            if (!e.isRepeat)
+            {
+                publishEvent(channel, e, ActionStatus::STARTED, e.start);
+            }
+        }
+
+        if (e.end < 0.0 || now < e.end)
+        {
+            e.peakVelocity = std::max(e.peakVelocity, velocity);
             break;
         }
+
+        yInfo() << "Gesture" << e.gesture->name << "took" << e.end - e.start << "seconds on the" << channel.name
+                << "arm || peak joint velocity:" << e.peakVelocity << "deg/s";
+
+        if (!e.isContinued)
+        {
+            publishEvent(channel, e, e.outcome, e.end);
+        }
+
+        executions[0] = executions[1];
+        channel.executionCount--;
     }
+}
 
-    return true;
+void FollowMeArmExecution::publishEvent(const channel_t & channel, const execution_t & execution, ActionStatus status,
+                                        double timestamp)
+{
+    if (!events.push({timestamp, execution.gesture->name.c_str(), channel.name, status}))
+    {
+        yWarningThrottle(1.0) << "Event queue full, dropped" << execution.gesture->name << "event on the" << channel.name << "arm";
+    }
 }
 
 void FollowMeArmExecution::doGreet()
 {
-    registerSetpoints(state::GREET, {
-        {armZeros, {-45.0, 0.0, -20.0, -80.0, 0.0, 0.0}},
-    });
+    postCommand(command_type::PLAY, greetGesture);
 }
 
 void FollowMeArmExecution::doSignalLeft()
 {
-    registerSetpoints(state::SIGNAL_LEFT, {
-        {{-50.0, 20.0, -10.0, -70.0, -20.0, -40.0}, armZeros},
-        {{-50.0, 20.0, -10.0, -70.0, -20.0, 0.0}, armZeros},
-    });
+    postCommand(command_type::PLAY, signalLeftGesture);
 }
 
 void FollowMeArmExecution::doSignalRight()
 {
-    registerSetpoints(state::SIGNAL_RIGHT, {
-        {armZeros, {-50.0, 20.0, -10.0, -70.0, -20.0, -40.0}},
-        {armZeros, {-50.0, 20.0, -10.0, -70.0, -20.0, 0.0}},
-    });
+    postCommand(command_type::PLAY, signalRightGesture);
 }
 
 void FollowMeArmExecution::enableArmSwinging()
 {
-    registerSetpoints(state::SWING, {
-        {{20.0, 5.0, 0.0, 0.0, 0.0, 0.0}, {-20.0, -5.0, 0.0, 0.0, 0.0, 0.0}},
-        {{-20.0, 5.0, 0.0, 0.0, 0.0, 0.0}, {20.0, -5.0, 0.0, 0.0, 0.0, 0.0}},
-    });
+    postCommand(command_type::PLAY, swingGesture);
 }
 
 void FollowMeArmExecution::disableArmSwinging()
 {
-    registerSetpoints(state::HOMING, {
-        {armZeros, armZeros}
-    });
+    postCommand(command_type::PLAY, homeGesture);
+}
+
+bool FollowMeArmExecution::setSwingParameters(double amplitude, double frequency)
+{
+    if (amplitude < 0.0 || amplitude > MAX_SWING_AMPLITUDE || frequency <= 0.0 || frequency > MAX_SWING_FREQUENCY)
+    {
+        yWarning() << "Invalid swing parameters, amplitude:" << amplitude << "frequency:" << frequency;
+        return false;
+    }
+
+    yInfo() << "Swing amplitude:" << amplitude << "degrees, frequency:" << frequency << "Hz";
+    return postCommand(command_type::SET_SWING, -1, amplitude, frequency);
+}
+
+bool FollowMeArmExecution::setSpeedFactor(double factor)
+{
+    if (factor <= 0.0 || factor > MAX_SPEED_FACTOR)
+    {
+        yWarning() << "Speed factor must lie in (0," << MAX_SPEED_FACTOR << "], got:" << factor;
+        return false;
+    }
+
+    yInfo() << "Speed factor:" << factor;
+    return postCommand(command_type::SET_SPEED, -1, factor);
+}
+
+bool FollowMeArmExecution::playGesture(const std::string & name)
+{
+    auto index = findGesture(name);
+
+    if (index < 0)
+    {
+        yWarning() << "Unknown gesture:" << name;
+        return false;
+    }
+
+    return postCommand(command_type::PLAY, index);
 }
 
 bool FollowMeArmExecution::stop()
 {
     yInfo() << "Received stop command";
+    return postCommand(command_type::STOP);
+}
+
+bool FollowMeArmExecution::loadGestures(const std::string & path)
+{
+    yarp::os::Property config;
+
+    if (path.empty() || !config.fromConfigFile(path))
+    {
+        yError() << "Failed to load gesture library:" << path;
+        return false;
+    }
+
+    const auto * names = config.find("gestures").asList();
+
+    if (!names || names->size() == 0 || names->size() > MAX_GESTURES)
+    {
+        yError() << "Gesture library must list 1 to" << MAX_GESTURES << "gestures";
+        return false;
+    }
+
+    std::array<std::string, MAX_GESTURES> nextNames;
+    gestureCount = 0;
+
+    for (auto i = 0U; i < names->size(); i++)
+    {
+        auto name = names->get(i).asString();
+        const auto & group = config.findGroup(name);
+
+        if (name.empty() || group.isNull() || findGesture(name) >= 0)
+        {
+            yError() << "Missing or duplicate gesture:" << names->get(i).toString();
+            return false;
+        }
+
+        auto & g = gestures[gestureCount];
+        g.name = name;
+        g.jointCount = 0;
+        g.armOffsets.fill(-1);
+        g.waypointCount = 0;
+        g.loop = group.check("loop", yarp::os::Value(false)).asBool();
+        g.next = -1;
+        g.priority = group.check("priority", yarp::os::Value(0)).asInt32();
+        nextNames[gestureCount] = group.check("then", yarp::os::Value("")).asString();
 
+        auto policy = group.check("policy", yarp::os::Value("preempt")).asString();
+
+        if (policy == "preempt")
+        {
+            g.policy = schedule_policy::PREEMPT;
+        }
+        else if (policy == "enqueue")
+        {
+            g.policy = schedule_policy::ENQUEUE;
+        }
+        else if (policy == "merge")
+        {
+            g.policy = schedule_policy::MERGE;
+        }
+        else
+        {
+            yError() << "Gesture" << name << "must use 'preempt', 'enqueue' or 'merge' policy, got:" << policy;
+            return false;
+        }
+
+        auto arms = group.check("arms", yarp::os::Value("both")).asString();
+        bool hasLeft = arms == "left" || arms == "both";
+        bool hasRight = arms == "right" || arms == "both";
+
+        if (!hasLeft && !hasRight)
+        {
+            yError() << "Gesture" << name << "must use 'left', 'right' or 'both' arms, got:" << arms;
+            return false;
+        }
+
+        for (auto j = 0U; j < NUM_JOINTS; j++)
+        {
+            if (j < NUM_ARM_JOINTS ? hasLeft : hasRight)
+            {
+                if (j % NUM_ARM_JOINTS == 0)
+                {
+                    g.armOffsets[j / NUM_ARM_JOINTS] = g.jointCount;
+                }
+
+                g.joints[g.jointCount++] = j;
+            }
+        }
+
+        const auto * waypoints = group.find("waypoints").asList();
+
+        if (!waypoints || waypoints->size() == 0 || waypoints->size() > MAX_WAYPOINTS)
+        {
+            yError() << "Gesture" << name << "must have 1 to" << MAX_WAYPOINTS << "waypoints";
+            return false;
+        }
+
+        for (auto j = 0U; j < waypoints->size(); j++)
+        {
+            const auto * description = waypoints->get(j).asList();
+
+            if (!description)
+            {
+                yError() << "Waypoint" << j << "of gesture" << name << "must be a list";
+                return false;
+            }
+
+            auto & w = g.waypoints[g.waypointCount++];
+            std::size_t count = 0;
+
+            for (const auto & [arm, isUsed] : {std::make_pair("left", hasLeft), std::make_pair("right", hasRight)})
+            {
+                if (!isUsed)
+                {
+                    continue;
+                }
+
+                const auto * positions = description->find(arm).asList();
+
+                if (!positions || positions->size() != NUM_ARM_JOINTS)
+                {
+                    yError() << "Waypoint" << j << "of gesture" << name << "needs" << NUM_ARM_JOINTS << arm << "arm positions";
+                    return false;
+                }
+
+                for (auto k = 0U; k < NUM_ARM_JOINTS; k++)
+                {
+                    w.positions[count++] = positions->get(k).asFloat64();
+                }
+            }
+
+            w.speed = description->check("speed", yarp::os::Value(0.0)).asFloat64();
+            w.dwell = description->check("dwell", yarp::os::Value(0.0)).asFloat64();
+
+            if (w.speed < 0.0 || w.dwell < 0.0)
+            {
+                yError() << "Waypoint" << j << "of gesture" << name << "has negative speed or dwell time";
+                return false;
+            }
+        }
+
+        gestureCount++;
+    }
+
+    for (auto i = 0U; i < gestureCount; i++)
+    {
+        if (nextNames[i].empty())
+        {
+            continue;
+        }
+
+        if (gestures[i].loop || (gestures[i].next = findGesture(nextNames[i])) < 0)
+        {
+            yError() << "Gesture" << gestures[i].name << "can't be followed by" << nextNames[i];
+            return false;
+        }
+    }
+
+    greetGesture = findGesture("greet");
+    signalLeftGesture = findGesture("signalLeft");
+    signalRightGesture = findGesture("signalRight");
+    swingGesture = findGesture("swing");
+    homeGesture = findGesture("home");
+
+    if (greetGesture < 0 || signalLeftGesture < 0 || signalRightGesture < 0 || swingGesture < 0 || homeGesture < 0)
+    {
+        yError() << "Gesture library must provide greet, signalLeft, signalRight, swing and home";
+        return false;
+    }
+
+    const auto & swing = gestures[swingGesture];
+
+    if (swing.waypointCount != 2)
+    {
+        yError() << "Swing gesture must consist of two waypoints, got" << swing.waypointCount;
+        return false;
+    }
+
+    SwingOscillator::vector_t center {};
+    SwingOscillator::vector_t shape {};
+    swingExcursion = 0.0;
+
+    for (auto i = 0U; i < swing.jointCount; i++)
+    {
+        auto j = swing.joints[i];
+        center[j] = (swing.waypoints[0].positions[i] + swing.waypoints[1].positions[i]) / 2.0;
+        shape[j] = (swing.waypoints[0].positions[i] - swing.waypoints[1].positions[i]) / 2.0;
+        swingExcursion = std::max(swingExcursion, std::abs(shape[j]));
+    }
+
+    if (swingExcursion == 0.0)
+    {
+        yError() << "Swing gesture waypoints must differ";
+        return false;
+    }
+
+    oscillator.setPattern(center, shape);
+
+    yInfo() << "Loaded" << gestureCount << "gestures from" << path;
+    return true;
+}
+
+int FollowMeArmExecution::findGesture(const std::string & name) const
+{
+    for (auto i = 0U; i < gestureCount; i++)
+    {
+        if (gestures[i].name == name)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+bool FollowMeArmExecution::postCommand(command_type type, int gesture, double value1, double value2)
+{
+    if (!commands.push({type, gesture, {value1, value2}}))
+    {
+        yWarning() << "Command queue is full, dropping request";
+        return false;
+    }
+
+    return true;
+}
+
+void FollowMeArmExecution::processCommands()
+{
+    command_t command;
+
+    while (commands.pop(command))
+    {
+        switch (command.type)
+        {
+        case command_type::PLAY:
+            scheduleGesture(gestures[command.gesture]);
+            break;
+
+        case command_type::STOP:
+            haltArms();
+            break;
+
+        case command_type::SET_SWING:
+            swingAmplitude = command.values[0];
+            swingFrequency = command.values[1];
+            break;
+
+        case command_type::SET_SPEED:
+            speedFactor = command.values[0]; // applies from the next waypoint on
+            break;
+        }
+    }
+}
+
+void FollowMeArmExecution::scheduleGesture(const gesture_t & gesture)
+{
+    for (auto & channel : channels)
+    {
+        if (gesture.armOffsets[channel.index] < 0)
+        {
+            continue; // the other arm keeps doing whatever it was doing
+        }
+
+        const auto * current = channel.currentGesture;
+        auto pendingEnd = channel.pending.cbegin() + channel.pendingCount;
+
+        if (gesture.policy == schedule_policy::MERGE &&
+            (current == &gesture || std::find(channel.pending.cbegin(), pendingEnd, &gesture) != pendingEnd))
+        {
+            continue; // already there
+        }
+
+        if (!current || (gesture.policy == schedule_policy::PREEMPT && gesture.priority >= current->priority))
+        {
+            yInfo() << "Registered new action:" << gesture.name << "on the" << channel.name << "arm";
+            assignGesture(channel, gesture);
+        }
+        else if (channel.pendingCount < MAX_PENDING)
+        {
+            yInfo() << "Queued action:" << gesture.name << "on the" << channel.name << "arm";
+            channel.pending[channel.pendingCount++] = &gesture;
+        }
+        else
+        {
+            yWarning() << "Too many pending actions on the" << channel.name << "arm, dropping" << gesture.name;
+        }
+    }
+}
+
+void FollowMeArmExecution::assignGesture(channel_t & channel, const gesture_t & gesture)
+{
+    channel.currentGesture = &gesture;
+    channel.nextWaypoint = 0;
+    channel.hasNewSetpoints = true;
+}
+
+const FollowMeArmExecution::gesture_t * FollowMeArmExecution::nextGesture(channel_t & channel)
+{
+    if (channel.pendingCount != 0)
+    {
+        const auto * next = channel.pending[0];
+
+        for (auto i = 1U; i < channel.pendingCount; i++)
+        {
+            channel.pending[i - 1] = channel.pending[i];
+        }
+
+        channel.pendingCount--;
+        return next;
+    }
+
+    auto next = channel.currentGesture->next;
+
+    if (next >= 0 && gestures[next].armOffsets[channel.index] >= 0)
+    {
+        return &gestures[next];
+    }
+
+    return nullptr;
+}
+
+bool FollowMeArmExecution::haltArms()
+{
+    auto now = yarp::os::Time::now();
+    std::array<int, NUM_JOINTS> stopped; // joints in position mode
+    std::size_t stoppedCount = 0;
+
+    for (auto & channel : channels)
+    {
+        endExecution(channel, now, ActionStatus::PREEMPTED);
+        channel.currentGesture = nullptr;
+        channel.pendingCount = 0;
+        channel.hasNewSetpoints = false;
+        channel.hasStopRequest = true;
+
+        auto isStreamed = channel.isSwinging || channel.isReleasingSwing;
+
+        if (isStreamed)
+        {
+            // no fade-out over a swing cycle, the arm is ramped down at the acceleration limit right away
+            SwingOscillator::vector_t position, velocity;
+            oscillator.evaluate(now, position, velocity);
+            oscillator.disengage(channel.joints.data(), channel.joints.size());
+            channel.isSwinging = false;
+            channel.isReleasingSwing = false;
+
+            if (controlMode == control_mode::DIRECT)
+            {
+                BlendedTrajectory::vector_t rampVelocity {};
+
+                for (auto j : channel.joints)
+                {
+                    reference[j] = position[j];
+                    rampVelocity[j] = velocity[j];
+                }
+
+                channel.trajectory.reset(now, reference, rampVelocity);
+            }
+            else if (setControlModes(channel, VOCAB_CM_POSITION))
+            {
+                isStreamed = false; // the board takes over from its current reference
+            }
+            else
+            {
+                yWarning() << "Failed to restore position control mode for" << channel.name << "arm";
+            }
+        }
+
+        if (controlMode == control_mode::POSITION && !isStreamed)
+        {
+            std::copy(channel.joints.cbegin(), channel.joints.cend(), stopped.begin() + stoppedCount);
+            stoppedCount += channel.joints.size();
+        }
+    }
+
+    if (controlMode == control_mode::DIRECT || stoppedCount == 0)
     {
-        std::lock_guard lock(actionMutex);
-        currentState = state::REST;
-        currentSetpoints.clear();
-        hasNewSetpoints = false;
+        return true; // the sequencer ramps the arms down
     }
 
-    if (!armsIPositionControl->stop())
+    if (!armsIPositionControl->stop(stoppedCount, stopped.data()))
     {
         yError() << "Failed to stop arms";
         return false;
@@ -216,46 +1101,260 @@ bool FollowMeArmExecution::stop()
     return true;
 }
 
-void FollowMeArmExecution::registerSetpoints(state newState, std::initializer_list<setpoints_t> setpoints)
+double FollowMeArmExecution::predictArrival(const channel_t & channel, const gesture_t & gesture, const waypoint_t & waypoint,
+                                            double speed, double & peakVelocity)
+{
+    auto offset = gesture.armOffsets[channel.index];
+
+    // the slowest joint sets the pace, none may exceed its velocity limit
+    double duration = 0.0;
+
+    for (auto k = 0U; k < NUM_ARM_JOINTS; k++)
+    {
+        auto j = gesture.joints[offset + k];
+        auto distance = std::abs(waypoint.positions[offset + k] - commandedPositions[j]);
+        duration = std::max(duration, predictDuration(distance, std::min(speed, maxVelocities[j]), DEFAULT_REF_ACCELERATION));
+    }
+
+    peakVelocity = 0.0;
+
+    // slow down the remaining joints so that all of them arrive together
+    for (auto k = 0U; k < NUM_ARM_JOINTS; k++)
+    {
+        auto j = gesture.joints[offset + k];
+        auto distance = std::abs(waypoint.positions[offset + k] - commandedPositions[j]);
+
+        if (distance > 0.0)
+        {
+            plannedSpeeds[k] = synchronizeSpeed(distance, duration, DEFAULT_REF_ACCELERATION);
+            peakVelocity = std::max(peakVelocity, plannedSpeeds[k]);
+        }
+        else
+        {
+            plannedSpeeds[k] = speeds[j]; // not moving, keep as is
+        }
+
+        commandedPositions[j] = waypoint.positions[offset + k];
+    }
+
+    return duration;
+}
+
+bool FollowMeArmExecution::sendWaypoint(const channel_t & channel, const gesture_t & gesture, const waypoint_t & waypoint)
 {
-    yInfo() << "Registered new action:" << getStateDescription(newState);
+    auto offset = gesture.armOffsets[channel.index];
+    const auto * joints = gesture.joints.data() + offset;
+    bool hasNewSpeeds = false;
+
+    for (auto k = 0U; k < NUM_ARM_JOINTS; k++)
+    {
+        if (plannedSpeeds[k] != speeds[joints[k]])
+        {
+            speeds[joints[k]] = plannedSpeeds[k];
+            hasNewSpeeds = true;
+        }
+    }
+
+    if (hasNewSpeeds && !armsIPositionControl->setRefSpeeds(NUM_ARM_JOINTS, joints, plannedSpeeds.data()))
+    {
+        yWarning() << "Failed to set reference speeds for" << channel.name << "arm";
+    }
+
+    if (!armsIPositionControl->positionMove(NUM_ARM_JOINTS, joints, waypoint.positions.data() + offset))
+    {
+        yWarning() << "Failed to send new setpoints to" << channel.name << "arm";
+        return false;
+    }
 
-    std::lock_guard lock(actionMutex);
-    currentState = newState;
-    currentSetpoints.clear();
-    currentSetpoints.insert(currentSetpoints.end(), setpoints);
-    hasNewSetpoints = true;
+    sentWaypoints++;
+    return true;
 }
 
-bool FollowMeArmExecution::checkMotionDone()
+bool FollowMeArmExecution::checkMotionDone(const channel_t & channel)
 {
     bool motionDone = true;
+    motionQueries++;
 
-    if (!armsIPositionControl->checkMotionDone(&motionDone))
+    if (!armsIPositionControl->checkMotionDone(NUM_ARM_JOINTS, channel.joints.data(), &motionDone))
     {
-        yWarning() << "Unable to check motion state of arms";
+        yWarning() << "Unable to check motion state of" << channel.name << "arm";
     }
 
     return motionDone;
 }
 
-const char * FollowMeArmExecution::getStateDescription(state s)
+bool FollowMeArmExecution::readEncoders(const channel_t & channel, std::array<double, NUM_JOINTS> & positions)
+{
+    std::array<double, NUM_JOINTS> encoders;
+
+    if (!armsIEncoders->getEncoders(encoders.data()))
+    {
+        return false;
+    }
+
+    // leave the other arm alone
+    for (auto j : channel.joints)
+    {
+        positions[j] = encoders[j];
+    }
+
+    return true;
+}
+
+void FollowMeArmExecution::readGait(double now)
+{
+    while (auto * b = gaitPort.read(false))
+    {
+        if (b->size() != 2)
+        {
+            yWarningThrottle(1.0) << "Gait protocol error, expected 2 elements, got" << b->size();
+            continue;
+        }
+
+        // (phase cadence), gait cycles since the last left heel strike and gait cycles per second
+        auto phase = b->get(0).asFloat64();
+        auto cadence = b->get(1).asFloat64();
+
+        if (cadence <= 0.0 || cadence > MAX_SWING_FREQUENCY)
+        {
+            yWarningThrottle(1.0) << "Ignoring gait sample, cadence out of range:" << cadence;
+            continue;
+        }
+
+        auto timestamp = now;
+
+        // don't trust the sender's clock if it is obviously out of sync with ours, a skewed
+        // phase would be tracked as is and a stamp from the future would never time out
+        if (yarp::os::Stamp stamp; gaitPort.getEnvelope(stamp) && stamp.isValid())
+        {
+            if (auto latency = now - stamp.getTime(); latency >= 0.0 && latency < MAX_GAIT_LATENCY)
+            {
+                timestamp = stamp.getTime();
+            }
+        }
+
+        oscillator.synchronize(timestamp, phase, cadence);
+    }
+
+    if (oscillator.isSynchronized(now) != isGaitLocked)
+    {
+        isGaitLocked = !isGaitLocked;
+        yInfo() << (isGaitLocked ? "Arm swing locked to gait" : "Lost gait signal, arm swing runs freely");
+    }
+}
+
+bool FollowMeArmExecution::swingArm(channel_t & channel, double now)
+{
+    if (channel.currentGesture == &gestures[swingGesture] && channel.pendingCount != 0)
+    {
+        assignGesture(channel, *nextGesture(channel)); // idle motion, yield right away
+    }
+
+    if (channel.currentGesture != &gestures[swingGesture])
+    {
+        if (channel.isSwinging)
+        {
+            // fade out over a swing cycle, stopping dead would take a huge deceleration
+            auto transition = std::max(MIN_SWING_TRANSITION, 1.0 / swingFrequency);
+            oscillator.release(now, channel.joints.data(), channel.joints.size(), transition);
+            endExecution(channel, now, ActionStatus::PREEMPTED); // swinging never finishes by itself
+            channel.isSwinging = false;
+            channel.isReleasingSwing = true;
+            channel.releaseDeadline = now + transition;
+        }
+
+        if (!channel.isReleasingSwing)
+        {
+            return false;
+        }
+
+        if (now < channel.releaseDeadline)
+        {
+            SwingOscillator::vector_t position, velocity;
+            oscillator.evaluate(now, position, velocity);
+            streamReference(channel, now, position, velocity);
+            return true; // whatever comes next waits for the arm to come to rest
+        }
+
+        channel.isReleasingSwing = false;
+        oscillator.disengage(channel.joints.data(), channel.joints.size());
+        channel.trajectory.reset(now, reference);
+
+        if (controlMode == control_mode::POSITION && !setControlModes(channel, VOCAB_CM_POSITION))
+        {
+            yWarning() << "Failed to restore position control mode for" << channel.name << "arm";
+        }
+
+        return false;
+    }
+
+    if (!channel.isSwinging && !channel.hasNewSetpoints && controlMode == control_mode::DIRECT &&
+        !channel.trajectory.isFinished(now))
+    {
+        return false; // chained after a gesture, let it come to rest first
+    }
+
+    auto isNewSwing = !channel.isSwinging;
+    channel.hasNewSetpoints = false; // already swinging otherwise, just keep going
+    oscillator.setParameters(swingAmplitude / swingExcursion, swingFrequency);
+
+    if (isNewSwing && !startSwing(channel, now))
+    {
+        return false;
+    }
+
+    SwingOscillator::vector_t position, velocity;
+    oscillator.evaluate(now, position, velocity); // sampled once per cycle, shared by both arms
+    streamReference(channel, now, position, velocity);
+    return true;
+}
+
+bool FollowMeArmExecution::startSwing(channel_t & channel, double now)
 {
-    switch (s)
+    if (controlMode == control_mode::POSITION)
     {
-        case state::GREET:
-            return "greet";
-        case state::SIGNAL_LEFT:
-            return "signal left";
-        case state::SIGNAL_RIGHT:
-            return "signal right";
-        case state::SWING:
-            return "swinging arms";
-        case state::HOMING:
-            return "homing";
-        case state::REST:
-            return "none";
-        default:
-            return "unknown";
+        // the reference is only maintained while streaming
+        if (!readEncoders(channel, reference))
+        {
+            yWarning() << "Failed to read" << channel.name << "arm encoders";
+
+            for (auto j : channel.joints)
+            {
+                reference[j] = commandedPositions[j];
+            }
+        }
+
+        if (!setControlModes(channel, VOCAB_CM_POSITION_DIRECT))
+        {
+            yWarningThrottle(1.0) << "Failed to set position direct control mode for" << channel.name << "arm";
+            return false; // retried on the next cycle
+        }
+    }
+
+    const auto & swing = gestures[swingGesture];
+    auto offset = swing.armOffsets[channel.index];
+    double distance = 0.0;
+
+    for (auto k = 0U; k < NUM_ARM_JOINTS; k++)
+    {
+        auto i = offset + k;
+        auto center = (swing.waypoints[0].positions[i] + swing.waypoints[1].positions[i]) / 2.0;
+        distance = std::max(distance, std::abs(reference[swing.joints[i]] - center));
     }
+
+    // fade into the pattern at the scaled reference speed, smoothstep peaks at 1.5 times the mean speed
+    auto transition = std::max(MIN_SWING_TRANSITION, 1.5 * distance / (DEFAULT_REF_SPEED * speedFactor));
+
+    oscillator.engage(now, channel.joints.data(), channel.joints.size(), reference, transition);
+    channel.isSwinging = true;
+    channel.isReleasingSwing = false;
+    beginExecution(channel, swing, now);
+    return true;
+}
+
+bool FollowMeArmExecution::setControlModes(const channel_t & channel, int mode)
+{
+    std::array<int, NUM_ARM_JOINTS> modes;
+    modes.fill(mode);
+    return armsIControlMode->setControlModes(NUM_ARM_JOINTS, channel.joints.data(), modes.data());
 }
@@ -4,18 +4,28 @@
 #define __FOLLOW_ME_ARM_EXECUTION_HPP__
 
 #include <array>
-#include <deque>
-#include <initializer_list>
-#include <mutex>
-#include <tuple>
-
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/PeriodicThread.h>
 #include <yarp/os/RFModule.h>
 
+#include <yarp/dev/IControlLimits.h>
 #include <yarp/dev/IControlMode.h>
+#include <yarp/dev/IEncoders.h>
 #include <yarp/dev/IPositionControl.h>
+#include <yarp/dev/IPositionDirect.h>
 #include <yarp/dev/PolyDriver.h>
 
+#include "ActionEvent.h"
+#include "BlendedTrajectory.hpp"
+#include "CommandQueue.hpp"
 #include "FollowMeArmCommands.h"
+#include "SwingOscillator.hpp"
 
 namespace roboticslab
 {
@@ -23,13 +33,31 @@ namespace roboticslab
 /**
  * @ingroup followMeArmExecution
  * @brief Arm Execution Core.
+ *
+ * Gestures are loaded from a configuration file at startup into a preallocated
+ * table, playing them back does not allocate memory. In position mode, a fast
+ * sequencer thread predicts when the arms reach each waypoint and sends the next
+ * one right away, motion state is only queried to confirm the end of a gesture.
+ * In direct mode, waypoints are blended into a continuous trajectory that is
+ * streamed to the arms. Arm swinging is generated by an oscillator in both modes,
+ * optionally phase-locked to the gait. Each arm is sequenced on its own, so that
+ * one of them may gesture while the other keeps swinging.
+ *
+ * RPC handlers never touch the sequencer state, they post commands to a lock-free
+ * queue instead. Incoming gestures preempt, follow or merge with the ongoing ones
+ * of each arm depending on their priority and scheduling policy.
+ *
+ * The start and outcome of every action on each arm are published as events, so
+ * that clients know when to move on without guessing how long a gesture takes.
+ * Looping gestures are reported once, until they are left. Events are handed
+ * over to the module thread through another lock-free queue and written there.
  */
 class FollowMeArmExecution : public yarp::os::RFModule,
+                             public yarp::os::PeriodicThread,
                              public FollowMeArmCommands
 {
 public:
-    using setpoints_arm_t = std::array<double, 6>;
-    using setpoints_t = std::tuple<setpoints_arm_t, setpoints_arm_t>;
+    FollowMeArmExecution();
 
     ~FollowMeArmExecution()
     { close(); }
@@ -40,30 +68,180 @@ public:
     double getPeriod() override;
     bool updateModule() override;
 
+    void run() override;
+
     void doGreet() override;
     void doSignalLeft() override;
     void doSignalRight() override;
     void enableArmSwinging() override;
     void disableArmSwinging() override;
+    bool setSwingParameters(double amplitude, double frequency) override;
+    bool setSpeedFactor(double factor) override;
+    bool playGesture(const std::string & name) override;
     bool stop() override;
 
 private:
-    enum class state { GREET, SIGNAL_LEFT, SIGNAL_RIGHT, SWING, HOMING, REST };
-
-    void registerSetpoints(state newState, std::initializer_list<setpoints_t> setpoints);
-    bool checkMotionDone();
-    static const char * getStateDescription(state s);
-
-    std::deque<setpoints_t> currentSetpoints;
-    std::mutex actionMutex;
-    bool hasNewSetpoints {false};
-    state currentState {state::REST};
+    enum class control_mode { POSITION, DIRECT };
+    enum class schedule_policy { PREEMPT, ENQUEUE, MERGE };
+    enum class command_type { PLAY, STOP, SET_SWING, SET_SPEED };
+
+    static constexpr std::size_t MAX_GESTURES = 32;
+    static constexpr std::size_t MAX_WAYPOINTS = 16;
+    static constexpr std::size_t MAX_PENDING = 8; // per arm
+    static constexpr std::size_t MAX_COMMANDS = 16;
+    static constexpr std::size_t MAX_EVENTS = 32;
+    static constexpr std::size_t NUM_ARMS = 2;
+    static constexpr std::size_t NUM_ARM_JOINTS = 6;
+    static constexpr std::size_t NUM_JOINTS = NUM_ARMS * NUM_ARM_JOINTS; // left arm first
+
+    struct waypoint_t
+    {
+        std::array<double, NUM_JOINTS> positions; // [deg], one per commanded joint of the gesture
+        double speed; // [deg/s], zero for the default reference speed
+        double dwell; // [s]
+    };
+
+    struct gesture_t
+    {
+        std::string name;
+        std::array<int, NUM_JOINTS> joints;
+        std::size_t jointCount;
+        std::array<int, NUM_ARMS> armOffsets; // first joint of each arm in the lists above, negative if unused
+        std::array<waypoint_t, MAX_WAYPOINTS> waypoints;
+        std::size_t waypointCount;
+        bool loop;
+        int next; // gesture to play afterwards, negative to rest
+        int priority;
+        schedule_policy policy;
+    };
+
+    struct command_t
+    {
+        command_type type;
+        int gesture;
+        double values[2];
+    };
+
+    // published by the module thread, so that a stalled client never blocks the sequencer
+    struct pending_event_t
+    {
+        double timestamp; // [s]
+        const char * action; // gesture name, the table is not modified while running
+        const char * part;
+        ActionStatus status;
+    };
+
+    struct execution_t
+    {
+        const gesture_t * gesture;
+        double start; // [s]
+        double end; // [s], negative while unknown
+        double peakVelocity; // [deg/s]
+        bool isRepeat; // loop iteration, the start is not reported again
+        bool isContinued; // followed by a loop iteration, the end is not reported
+        bool hasStarted;
+        ActionStatus outcome;
+    };
+
+    // each arm plays its own gestures, a gesture for both arms is started on both
+    struct channel_t
+    {
+        const char * name;
+        std::size_t index;
+        std::array<int, NUM_ARM_JOINTS> joints;
+        std::atomic<int> activeGesture {-1}; // published for the module thread
+
+        // owned by the sequencer thread
+        const gesture_t * currentGesture {nullptr};
+        std::array<const gesture_t *, MAX_PENDING> pending; // FIFO
+        std::size_t pendingCount {0};
+        std::size_t nextWaypoint {0};
+        bool hasNewSetpoints {false};
+        bool hasStopRequest {false};
+        double currentDwell {0.0};
+        double arrivalTime {0.0}; // [s], predicted
+        double nextMotionCheck {0.0};
+        bool isDwellPending {false};
+        double dwellDeadline {0.0};
+        BlendedTrajectory trajectory;
+        std::array<execution_t, 2> executions; // ongoing and upcoming
+        std::size_t executionCount {0};
+        bool isSwinging {false};
+        bool isReleasingSwing {false};
+        double releaseDeadline {0.0};
+    };
+
+    static_assert(NUM_JOINTS == BlendedTrajectory::MAX_JOINTS);
+    static_assert(NUM_JOINTS == SwingOscillator::MAX_JOINTS);
+
+    bool loadGestures(const std::string & path);
+    int findGesture(const std::string & name) const;
+    bool postCommand(command_type type, int gesture = -1, double value1 = 0.0, double value2 = 0.0);
+    void processCommands();
+    void scheduleGesture(const gesture_t & gesture);
+    void assignGesture(channel_t & channel, const gesture_t & gesture);
+    const gesture_t * nextGesture(channel_t & channel);
+    bool haltArms();
+    void readGait(double now);
+    bool swingArm(channel_t & channel, double now);
+    bool startSwing(channel_t & channel, double now);
+    void sequenceGestures(channel_t & channel, double now);
+    void streamGestures(channel_t & channel, double now);
+    void streamReference(channel_t & channel, double now, const BlendedTrajectory::vector_t & position,
+                         const BlendedTrajectory::vector_t & velocity);
+    void beginExecution(channel_t & channel, const gesture_t & gesture, double start, bool isRepeat = false);
+    void endExecution(channel_t & channel, double end, ActionStatus outcome);
+    void updateExecutions(channel_t & channel, double now, double velocity);
+    void publishEvent(const channel_t & channel, const execution_t & execution, ActionStatus status, double timestamp);
+    double predictArrival(const channel_t & channel, const gesture_t & gesture, const waypoint_t & waypoint, double speed,
+                          double & peakVelocity);
+    bool sendWaypoint(const channel_t & channel, const gesture_t & gesture, const waypoint_t & waypoint);
+    bool checkMotionDone(const channel_t & channel);
+    bool readEncoders(const channel_t & channel, std::array<double, NUM_JOINTS> & positions);
+    bool setControlModes(const channel_t & channel, int mode);
+
+    control_mode controlMode {control_mode::POSITION};
+
+    std::array<gesture_t, MAX_GESTURES> gestures;
+    std::size_t gestureCount {0};
+
+    // gestures bound to the legacy commands
+    int greetGesture {-1};
+    int signalLeftGesture {-1};
+    int signalRightGesture {-1};
+    int swingGesture {-1};
+    int homeGesture {-1};
+    double swingExcursion {0.0}; // [deg], largest joint excursion in the swing gesture
+
+    CommandQueue<command_t, MAX_COMMANDS> commands;
+    CommandQueue<pending_event_t, MAX_EVENTS> events;
+    std::array<channel_t, NUM_ARMS> channels;
+
+    // owned by the sequencer thread, each channel only touches the joints of its arm
+    double swingAmplitude {0.0}; // [deg]
+    double swingFrequency {0.0}; // [Hz]
+    double speedFactor {1.0}; // scales waypoint speeds
+    std::array<double, NUM_JOINTS> commandedPositions {}; // [deg]
+    std::array<double, NUM_JOINTS> speeds; // [deg/s], last reference speed of each joint
+    std::array<double, NUM_ARM_JOINTS> plannedSpeeds; // [deg/s], next waypoint of either arm
+    std::array<double, NUM_JOINTS> maxVelocities; // [deg/s]
+    BlendedTrajectory::vector_t reference {}; // [deg]
+    SwingOscillator oscillator;
+    bool isGaitLocked {false};
+
+    std::atomic<std::int64_t> sentWaypoints {0};
+    std::atomic<std::int64_t> motionQueries {0};
 
     yarp::dev::PolyDriver armsDevice;
+    yarp::dev::IControlLimits * armsIControlLimits;
     yarp::dev::IControlMode * armsIControlMode;
+    yarp::dev::IEncoders * armsIEncoders;
     yarp::dev::IPositionControl * armsIPositionControl;
+    yarp::dev::IPositionDirect * armsIPositionDirect;
 
     yarp::os::RpcServer serverPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> gaitPort;
+    yarp::os::BufferedPort<ActionEvent> eventPort;
 };
 
 } // namespace roboticslab
@@ -0,0 +1,176 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "SwingOscillator.hpp"
+
+#include <cmath> // std::abs, std::cos, std::floor, std::round
+
+#include <algorithm> // std::find, std::max, std::min
+
+using namespace roboticslab;
+
+constexpr auto TWO_PI = 6.283185307179586;
+constexpr auto AMPLITUDE_TIME_CONSTANT = 0.5; // [s]
+constexpr auto FREQUENCY_TIME_CONSTANT = 1.0; // [s]
+constexpr auto PHASE_GAIN = 0.5; // [Hz/cycle], corrects a quarter cycle lag in ~2 s
+constexpr auto GAIT_TIMEOUT = 2.0; // [s]
+
+namespace
+{
+    double wrap(double cycles)
+    {
+        return cycles - std::floor(cycles);
+    }
+
+    double smoothstep(double s)
+    {
+        return s * s * (3.0 - 2.0 * s);
+    }
+}
+
+void SwingOscillator::setPattern(const vector_t & center, const vector_t & shape)
+{
+    this->center = center;
+    this->shape = shape;
+}
+
+void SwingOscillator::setParameters(double amplitude, double frequency)
+{
+    targetAmplitude = amplitude;
+    targetFrequency = frequency;
+}
+
+void SwingOscillator::engage(double timestamp, const int * joints, std::size_t count, const vector_t & position, double transition)
+{
+    if (!isActive())
+    {
+        // start at the extreme reached first in a gait cycle
+        amplitude = 0.0;
+        frequency = targetFrequency;
+        phase = isSynchronized(timestamp) ? wrap(gaitPhase + gaitFrequency * (timestamp - gaitTime)) : 0.0;
+        lastTime = timestamp;
+    }
+
+    for (auto i = 0U; i < count; i++)
+    {
+        auto j = joints[i];
+        engaged[j] = true;
+        releasing[j] = false;
+        offset[j] = position[j] - center[j];
+        fadeStart[j] = timestamp;
+        fadeDuration[j] = transition;
+
+        // begin at rest, as if sampled right now
+        lastPosition[j] = position[j];
+        lastVelocity[j] = 0.0;
+    }
+}
+
+void SwingOscillator::release(double timestamp, const int * joints, std::size_t count, double transition)
+{
+    for (auto i = 0U; i < count; i++)
+    {
+        auto j = joints[i];
+        releasing[j] = true;
+        releaseStart[j] = timestamp;
+        releaseDuration[j] = transition;
+    }
+}
+
+void SwingOscillator::disengage(const int * joints, std::size_t count)
+{
+    for (auto i = 0U; i < count; i++)
+    {
+        engaged[joints[i]] = false;
+        releasing[joints[i]] = false;
+    }
+}
+
+bool SwingOscillator::isActive() const
+{
+    return std::find(engaged.cbegin(), engaged.cend(), true) != engaged.cend();
+}
+
+void SwingOscillator::synchronize(double timestamp, double phase, double frequency)
+{
+    gaitTime = timestamp;
+    gaitPhase = wrap(phase);
+    gaitFrequency = frequency;
+}
+
+void SwingOscillator::evaluate(double timestamp, vector_t & position, vector_t & velocity)
+{
+    auto dt = timestamp - lastTime;
+
+    if (dt <= 0.0)
+    {
+        position = lastPosition;
+        velocity = lastVelocity;
+        return;
+    }
+
+    auto desiredFrequency = targetFrequency;
+
+    if (isSynchronized(timestamp))
+    {
+        // phase-locked loop, the gait cadence is tracked and the remaining phase error is nulled
+        auto expected = wrap(gaitPhase + gaitFrequency * (timestamp - gaitTime));
+        auto error = expected - phase;
+        error -= std::round(error); // shortest way, [-0.5, 0.5]
+        desiredFrequency = std::max(0.0, gaitFrequency + PHASE_GAIN * error);
+    }
+
+    // first-order response to parameter changes, keeps references continuous
+    frequency += (desiredFrequency - frequency) * std::min(1.0, dt / FREQUENCY_TIME_CONSTANT);
+
+    auto limitedAmplitude = targetAmplitude;
+
+    for (auto j = 0U; j < MAX_JOINTS; j++)
+    {
+        // peak velocity of the wave is 2 * pi * f * amplitude * |shape|
+        auto peak = TWO_PI * frequency * std::abs(shape[j]);
+
+        if (peak * limitedAmplitude > maxVelocities[j])
+        {
+            limitedAmplitude = maxVelocities[j] / peak;
+        }
+    }
+
+    amplitude += (limitedAmplitude - amplitude) * std::min(1.0, dt / AMPLITUDE_TIME_CONSTANT);
+    phase = wrap(phase + frequency * dt);
+
+    auto wave = amplitude * std::cos(TWO_PI * phase);
+
+    for (auto j = 0U; j < MAX_JOINTS; j++)
+    {
+        if (!engaged[j])
+        {
+            lastVelocity[j] = 0.0; // hold
+            continue;
+        }
+
+        auto s = fadeDuration[j] > 0.0 ? std::min(1.0, (timestamp - fadeStart[j]) / fadeDuration[j]) : 1.0;
+        auto weight = smoothstep(s); // both the deviation and the wave blend in smoothly
+        auto deviation = (1.0 - weight) * offset[j] + weight * wave * shape[j];
+
+        if (releasing[j])
+        {
+            // shrinks to nothing, the joint comes to rest at the center
+            auto r = releaseDuration[j] > 0.0 ? std::min(1.0, (timestamp - releaseStart[j]) / releaseDuration[j]) : 1.0;
+            deviation *= 1.0 - smoothstep(r);
+        }
+
+        auto next = center[j] + deviation;
+
+        lastVelocity[j] = (next - lastPosition[j]) / dt;
+        lastPosition[j] = next;
+    }
+
+    lastTime = timestamp;
+    position = lastPosition;
+    velocity = lastVelocity;
+}
+
+bool SwingOscillator::isSynchronized(double timestamp) const
+{
+    return gaitTime >= 0.0 && timestamp - gaitTime < GAIT_TIMEOUT;
+}
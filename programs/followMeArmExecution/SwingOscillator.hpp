@@ -0,0 +1,95 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __SWING_OSCILLATOR_HPP__
+#define __SWING_OSCILLATOR_HPP__
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeArmExecution
+ * @brief Phase-based periodic motion generator for arm swinging.
+ *
+ * Joint references follow center + amplitude * shape * cos(2 * pi * phase), with
+ * the phase measured in cycles. Amplitude and frequency changes are smoothed out,
+ * so they can be applied at any time without stopping. The phase may be locked
+ * to an external gait signal, otherwise the oscillator runs at its own frequency.
+ * Joints engage and disengage independently, all of them share the same phase.
+ */
+class SwingOscillator
+{
+public:
+    static constexpr std::size_t MAX_JOINTS = 12;
+
+    using vector_t = std::array<double, MAX_JOINTS>;
+
+    SwingOscillator()
+    { maxVelocities.fill(std::numeric_limits<double>::infinity()); }
+
+    //! Pattern of the swing, shape is scaled by the amplitude.
+    void setPattern(const vector_t & center, const vector_t & shape);
+
+    //! Target amplitude (scale of the shape) and free-running frequency [Hz].
+    void setParameters(double amplitude, double frequency);
+
+    //! Per-joint velocity limits [deg/s], the amplitude is reduced to honor them.
+    void setMaxVelocities(const vector_t & velocities)
+    { maxVelocities = velocities; }
+
+    //! Start oscillating the given joints from their current position, they fade into the pattern.
+    void engage(double timestamp, const int * joints, std::size_t count, const vector_t & position, double transition);
+
+    //! Fade the given joints out of the pattern, they come to rest at its center.
+    void release(double timestamp, const int * joints, std::size_t count, double transition);
+
+    //! Stop oscillating the given joints.
+    void disengage(const int * joints, std::size_t count);
+
+    //! Whether any joint is oscillating.
+    bool isActive() const;
+
+    //! Gait phase [cycles] and cadence [Hz] observed at the given instant.
+    void synchronize(double timestamp, double phase, double frequency);
+
+    //! Sample the motion, time is expected not to decrease, repeated queries yield the same sample.
+    void evaluate(double timestamp, vector_t & position, vector_t & velocity);
+
+    //! Whether the phase is currently locked to the gait signal.
+    bool isSynchronized(double timestamp) const;
+
+private:
+    vector_t center {};
+    vector_t shape {};
+    vector_t maxVelocities;
+
+    // per joint
+    std::array<bool, MAX_JOINTS> engaged {};
+    vector_t offset {}; // initial deviation from the pattern, fades out
+    vector_t fadeStart {}; // [s]
+    vector_t fadeDuration {}; // [s]
+    std::array<bool, MAX_JOINTS> releasing {};
+    vector_t releaseStart {}; // [s]
+    vector_t releaseDuration {}; // [s]
+
+    vector_t lastPosition {};
+    vector_t lastVelocity {};
+
+    double targetAmplitude {0.0};
+    double targetFrequency {1.0};
+    double amplitude {0.0};
+    double frequency {1.0};
+    double phase {0.0}; // [cycles], wrapped to [0, 1)
+    double lastTime {0.0};
+
+    double gaitTime {-1.0}; // negative until the first gait sample
+    double gaitPhase {0.0};
+    double gaitFrequency {0.0};
+};
+
+} // namespace roboticslab
+
+#endif // __SWING_OSCILLATOR_HPP__
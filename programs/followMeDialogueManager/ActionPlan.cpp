@@ -0,0 +1,140 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "ActionPlan.hpp"
+
+#include <algorithm> // std::min
+
+using namespace roboticslab;
+
+int ActionPlan::add(channel target, const std::string & what, int anchor, sync when, clock::duration delay, bool isOpenEnded)
+{
+    steps.push_back({{target, what, anchor, when, delay, isOpenEnded}, step_status::WAITING, {}, {}, 0, 0});
+    remaining++;
+    return steps.size() - 1;
+}
+
+void ActionPlan::clear()
+{
+    steps.clear();
+    remaining = 0;
+}
+
+void ActionPlan::start(clock::time_point now)
+{
+    schedule(NONE, sync::AFTER_START, now);
+}
+
+int ActionPlan::nextDue(clock::time_point now, bool isSpeaking) const
+{
+    for (auto i = 0U; i < steps.size(); i++)
+    {
+        const auto & s = steps[i];
+
+        if (s.status == step_status::DUE && now >= s.due && !(isSpeaking && s.step.target == channel::SPEECH))
+        {
+            return i;
+        }
+    }
+
+    return NONE;
+}
+
+void ActionPlan::markStarted(int step, clock::time_point now)
+{
+    steps[step].status = step_status::RUNNING;
+    steps[step].launched = now;
+    schedule(step, sync::AFTER_START, now);
+
+    if (steps[step].step.isOpenEnded)
+    {
+        markDone(step, now);
+    }
+}
+
+void ActionPlan::markDone(int step, clock::time_point now)
+{
+    if (steps[step].status == step_status::DONE)
+    {
+        return;
+    }
+
+    steps[step].status = step_status::DONE;
+    remaining--;
+    schedule(step, sync::AFTER_END, now);
+}
+
+void ActionPlan::processEvent(channel source, const std::string & action, bool isStart, clock::time_point now)
+{
+    for (auto i = 0U; i < steps.size(); i++)
+    {
+        auto & s = steps[i];
+
+        if (s.status != step_status::RUNNING || s.step.target != source || s.step.what != action)
+        {
+            continue;
+        }
+
+        if (isStart)
+        {
+            s.startedParts++;
+        }
+        else if (s.endedParts < s.startedParts) // stale events of a previous request don't count
+        {
+            s.endedParts++;
+        }
+
+        if (s.startedParts != 0 && s.endedParts >= s.startedParts)
+        {
+            markDone(i, now);
+        }
+
+        return;
+    }
+}
+
+int ActionPlan::findExpired(clock::time_point launchedBefore) const
+{
+    for (auto i = 0U; i < steps.size(); i++)
+    {
+        const auto & s = steps[i];
+
+        // speech is tracked by its owner
+        if (s.status == step_status::RUNNING && s.step.target != channel::SPEECH && s.launched < launchedBefore)
+        {
+            return i;
+        }
+    }
+
+    return NONE;
+}
+
+ActionPlan::clock::time_point ActionPlan::nextDeadline(clock::duration timeout, bool isSpeaking) const
+{
+    auto deadline = clock::time_point::max();
+
+    for (const auto & s : steps)
+    {
+        if (s.status == step_status::DUE && !(isSpeaking && s.step.target == channel::SPEECH))
+        {
+            deadline = std::min(deadline, s.due);
+        }
+        else if (s.status == step_status::RUNNING && s.step.target != channel::SPEECH)
+        {
+            deadline = std::min(deadline, s.launched + timeout);
+        }
+    }
+
+    return deadline;
+}
+
+void ActionPlan::schedule(int anchor, sync when, clock::time_point now)
+{
+    for (auto & s : steps)
+    {
+        if (s.status == step_status::WAITING && s.step.anchor == anchor && (anchor == NONE || s.step.when == when))
+        {
+            s.status = step_status::DUE;
+            s.due = now + s.step.delay;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __ACTION_PLAN_HPP__
+#define __ACTION_PLAN_HPP__
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeDialogueManager
+ * @brief Composition of speech, gestures and head motions executed concurrently.
+ *
+ * Each step starts along with the plan or is synchronized with the start or the
+ * end of a previous step, plus an optional delay (e.g. wave 200 ms into a sentence).
+ * The plan is done once all of its steps are, hence waiting for the plan means
+ * waiting for all of them. This class only keeps track of the schedule, launching
+ * each step and reporting its progress is up to the owner.
+ */
+class ActionPlan
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    enum class channel { SPEECH, ARMS, HEAD };
+    enum class sync { AFTER_START, AFTER_END };
+
+    static constexpr int NONE = -1;
+
+    struct step_t
+    {
+        channel target;
+        std::string what; // sentence, gesture or head action
+        int anchor; // step this one is synchronized with, NONE to start along with the plan
+        sync when;
+        clock::duration delay;
+        bool isOpenEnded; // done as soon as it starts, e.g. following
+    };
+
+    //! Append a step, returns its index to be used as an anchor of later steps.
+    int add(channel target, const std::string & what, int anchor = NONE, sync when = sync::AFTER_START,
+            clock::duration delay = clock::duration::zero(), bool isOpenEnded = false);
+
+    //! Remove all steps.
+    void clear();
+
+    //! Schedule the steps that start along with the plan.
+    void start(clock::time_point now);
+
+    //! First step that is due to be launched, NONE if there is none (speech steps wait for each other).
+    int nextDue(clock::time_point now, bool isSpeaking) const;
+
+    //! Report a step as launched, schedules the steps synchronized with its start.
+    void markStarted(int step, clock::time_point now);
+
+    //! Report a step as done, schedules the steps synchronized with its end.
+    void markDone(int step, clock::time_point now);
+
+    //! Account for an action event, the step is done once every part that started it has ended it.
+    void processEvent(channel source, const std::string & action, bool isStart, clock::time_point now);
+
+    //! First running step launched earlier than the given instant, NONE if there is none.
+    int findExpired(clock::time_point launchedBefore) const;
+
+    //! Earliest instant at which a step becomes due or runs out of time, speech steps wait for the ongoing one.
+    clock::time_point nextDeadline(clock::duration timeout, bool isSpeaking) const;
+
+    bool isDone() const
+    { return remaining == 0; }
+
+    const step_t & getStep(int step) const
+    { return steps[step].step; }
+
+private:
+    enum class step_status { WAITING, DUE, RUNNING, DONE };
+
+    struct scheduled_step_t
+    {
+        step_t step;
+        step_status status;
+        clock::time_point due;
+        clock::time_point launched;
+        int startedParts;
+        int endedParts;
+    };
+
+    void schedule(int anchor, sync when, clock::time_point now);
+
+    std::vector<scheduled_step_t> steps;
+    int remaining {0};
+};
+
+} // namespace roboticslab
+
+#endif // __ACTION_PLAN_HPP__
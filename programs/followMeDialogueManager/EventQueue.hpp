@@ -0,0 +1,69 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __EVENT_QUEUE_HPP__
+#define __EVENT_QUEUE_HPP__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeDialogueManager
+ * @brief Multi-producer, single-consumer FIFO queue of events with a blocking pop.
+ *
+ * Producers never wait for the consumer, which sleeps until either an event is
+ * pushed or the given deadline expires.
+ */
+template <typename T>
+class EventQueue
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    //! Append an event and wake up the consumer (producer side).
+    void push(T && event)
+    {
+        {
+            std::lock_guard lock(mutex);
+            events.push_back(std::move(event));
+        }
+
+        available.notify_one();
+    }
+
+    //! Retrieve the oldest event, returns false if none arrived before the deadline (consumer side).
+    bool pop(T & event, clock::time_point deadline)
+    {
+        std::unique_lock lock(mutex);
+
+        if (!available.wait_until(lock, deadline, [this] { return !events.empty(); }))
+        {
+            return false;
+        }
+
+        event = std::move(events.front());
+        events.pop_front();
+        return true;
+    }
+
+    //! Drop all pending events.
+    void clear()
+    {
+        std::lock_guard lock(mutex);
+        events.clear();
+    }
+
+private:
+    std::deque<T> events;
+    std::mutex mutex;
+    std::condition_variable available;
+};
+
+} // namespace roboticslab
+
+#endif // __EVENT_QUEUE_HPP__
@@ -2,8 +2,11 @@
 
 #include "FollowMeDialogueManager.hpp"
 
+#include <algorithm> // std::min, std::min_element
+#include <chrono>
+
 #include <yarp/os/LogStream.h>
-#include <yarp/os/SystemClock.h>
+#include <yarp/os/Property.h>
 
 using namespace roboticslab;
 
@@ -12,6 +15,8 @@ namespace
     using state = FollowMeDialogueManager::state;
     using snt = FollowMeDialogueManager::sentence;
     using cmd = FollowMeDialogueManager::command;
+    using channel = ActionPlan::channel;
+    using sync = ActionPlan::sync;
 
     const std::unordered_map<snt, std::string> englishSentences = {
         {snt::PRESENTATION_1, "Follow me, demostration started."},
@@ -29,13 +34,6 @@ namespace
         {snt::ON_THE_CENTER, "You are, on the, center."},
     };
 
-    const std::unordered_map<cmd, std::string> englishCommands = {
-        {cmd::HI_TEO, "hi teo"},
-        {cmd::FOLLOW_ME, "follow me"},
-        {cmd::MY_NAME_IS, "my name is"},
-        {cmd::STOP_FOLLOWING, "stop following"},
-    };
-
     const std::unordered_map<snt, std::string> spanishSentences = {
         {snt::PRESENTATION_1, "Demostración de detección de caras iniciada."},
         {snt::PRESENTATION_2, "Hola. Me yamo Teo, y soy un grobot humanoide diseñado por ingenieros de la universidad carlos tercero."},
@@ -52,11 +50,12 @@ namespace
         {snt::ON_THE_CENTER, "Ahora, estás, en el centro."},
     };
 
-    const std::unordered_map<cmd, std::string> spanishCommands = {
-        {cmd::HI_TEO, "hola teo"},
-        {cmd::FOLLOW_ME, "sigueme"},
-        {cmd::MY_NAME_IS, "me llamo"},
-        {cmd::STOP_FOLLOWING, "para teo"},
+    // keys of the language file
+    const std::unordered_map<std::string, cmd> commandNames = {
+        {"hiTeo", cmd::HI_TEO},
+        {"followMe", cmd::FOLLOW_ME},
+        {"myNameIs", cmd::MY_NAME_IS},
+        {"stopFollowing", cmd::STOP_FOLLOWING},
     };
 
     std::string getStateDescription(state s)
@@ -84,21 +83,31 @@ namespace
 constexpr auto DEFAULT_PREFIX = "/followMeDialogueManager";
 constexpr auto DEFAULT_LANGUAGE = "english";
 constexpr auto DEFAULT_MICRO = false;
+constexpr auto DEFAULT_MIN_MATCH_SCORE = 0.8; // one typo in a five-letter word
 constexpr auto ASR_DICTIONARY = "follow-me";
-constexpr auto SIGNAL_THRESHOLD = 10.0; // [deg]
-constexpr auto CENTER_THRESHOLD = 3.0; // [deg]
+constexpr auto STOP_CHECK_PERIOD = std::chrono::milliseconds(100);
+constexpr auto SAY_POLL_PERIOD = std::chrono::milliseconds(50); // the TTS server has no completion callback
+constexpr auto ECHO_GUARD = std::chrono::milliseconds(300); // keep the mic muted for a bit after speaking
+constexpr auto ACTION_TIMEOUT = std::chrono::seconds(10);
+constexpr auto GREET_DELAY = std::chrono::milliseconds(200); // wave along with the "hello"
+
+constexpr std::array answers {snt::ANSWER_1, snt::ANSWER_2, snt::ANSWER_3};
 
 bool FollowMeDialogueManager::configure(yarp::os::ResourceFinder & rf)
 {
     auto language = rf.check("language", yarp::os::Value(DEFAULT_LANGUAGE), "language to be used").asString();
+    auto commandsFile = rf.check("commands", yarp::os::Value(language + ".ini"), "voice command file").asString();
     usingMic = rf.check("useMic", "enable microphone");
+    minMatchScore = rf.check("minMatchScore", yarp::os::Value(DEFAULT_MIN_MATCH_SCORE), "minimum voice command score").asFloat64();
 
     if (rf.check("help"))
     {
         yInfo("FollowMeDialogueManager options:");
         yInfo("\t--help (this help)\t--from [file.ini]\t--context [path]");
         yInfo("\t--language: %s [%s]", language.c_str(), DEFAULT_LANGUAGE);
+        yInfo("\t--commands: %s [<language>.ini]", commandsFile.c_str());
         yInfo("\t--useMic: %d [%d]", usingMic, DEFAULT_MICRO);
+        yInfo("\t--minMatchScore: %f [%f]", minMatchScore, DEFAULT_MIN_MATCH_SCORE);
         return false;
     }
 
@@ -120,6 +129,27 @@ bool FollowMeDialogueManager::configure(yarp::os::ResourceFinder & rf)
         return false;
     }
 
+    if (!headZonePort.open(DEFAULT_PREFIX + std::string("/head/zone:i")))
+    {
+        yError() << "Failed to open head zone listener port" << headZonePort.getName();
+        return false;
+    }
+
+    armEventPort.setStrict(); // every event counts
+    headEventPort.setStrict();
+
+    if (!armEventPort.open(DEFAULT_PREFIX + std::string("/arms/events:i")))
+    {
+        yError() << "Failed to open arm event listener port" << armEventPort.getName();
+        return false;
+    }
+
+    if (!headEventPort.open(DEFAULT_PREFIX + std::string("/head/events:i")))
+    {
+        yError() << "Failed to open head event listener port" << headEventPort.getName();
+        return false;
+    }
+
     if (usingMic && !asrConfigClient.open(DEFAULT_PREFIX + std::string("/speechRecognition/rpc:c")))
     {
         yError() << "Failed to open ASR config client port" << asrConfigClient.getName();
@@ -135,10 +165,14 @@ bool FollowMeDialogueManager::configure(yarp::os::ResourceFinder & rf)
     armCommander.yarp().attachAsClient(armExecutionClient);
     headCommander.yarp().attachAsClient(headExecutionClient);
     tts.yarp().attachAsClient(ttsClient);
+    headZonePort.useCallback(zoneCallback);
+    armEventPort.useCallback(actionCallback);
+    headEventPort.useCallback(actionCallback);
 
     if (usingMic)
     {
         asr.yarp().attachAsClient(asrConfigClient);
+        inAsrPort.useCallback(speechCallback);
     }
 
     if (language == "english")
@@ -146,14 +180,12 @@ bool FollowMeDialogueManager::configure(yarp::os::ResourceFinder & rf)
         voice = "mb-en1";
         langCode = "en-us";
         sentences = englishSentences;
-        voiceCommands = englishCommands;
     }
     else if (language == "spanish")
     {
         voice = "mb-es1";
         langCode = "es";
         sentences = spanishSentences;
-        voiceCommands = spanishCommands;
     }
     else
     {
@@ -161,6 +193,42 @@ bool FollowMeDialogueManager::configure(yarp::os::ResourceFinder & rf)
         return false;
     }
 
+    return loadCommands(rf.findFileByName(commandsFile));
+}
+
+bool FollowMeDialogueManager::loadCommands(const std::string & path)
+{
+    yarp::os::Property config;
+
+    if (path.empty() || !config.fromConfigFile(path))
+    {
+        yError() << "Failed to load voice commands:" << path;
+        return false;
+    }
+
+    const auto & group = config.findGroup("commands");
+
+    for (const auto & [name, id] : commandNames)
+    {
+        const auto * phrases = group.find(name).asList();
+
+        if (!phrases || phrases->size() == 0)
+        {
+            yError() << "Missing phrases for voice command" << name;
+            return false;
+        }
+
+        for (auto i = 0U; i < phrases->size(); i++)
+        {
+            if (!matcher.addPhrase(static_cast<int>(id), phrases->get(i).asString()))
+            {
+                yError() << "Empty or duplicate phrase for voice command" << name << ":" << phrases->get(i).toString();
+                return false;
+            }
+        }
+    }
+
+    matcher.compile();
     return true;
 }
 
@@ -221,11 +289,18 @@ bool FollowMeDialogueManager::interruptModule()
     headExecutionClient.interrupt();
     armExecutionClient.interrupt();
     ttsClient.interrupt();
+    headZonePort.interrupt();
+    headZonePort.disableCallback();
+    armEventPort.interrupt();
+    armEventPort.disableCallback();
+    headEventPort.interrupt();
+    headEventPort.disableCallback();
 
     if (usingMic)
     {
         asrConfigClient.interrupt();
         inAsrPort.interrupt();
+        inAsrPort.disableCallback();
     }
 
     return yarp::os::Thread::stop();
@@ -236,6 +311,9 @@ bool FollowMeDialogueManager::close()
     headExecutionClient.close();
     armExecutionClient.close();
     ttsClient.close();
+    headZonePort.close();
+    armEventPort.close();
+    headEventPort.close();
 
     if (usingMic)
     {
@@ -265,106 +343,375 @@ bool FollowMeDialogueManager::threadInit()
 
 void FollowMeDialogueManager::run()
 {
-    ttsSayAndWait(sentence::PRESENTATION_1);
-    bool isFollowing = false;
+    events.clear(); // stale, the thread might have been restarted
+    timers.fill(clock::time_point::max());
+    isSpeaking = false;
+    isMicMuted = false;
+    isFollowing = false;
+    headZone = announcedZone = zone::UNKNOWN;
+    isTurnActive = false;
+
+    clearPlan();
+    plan.add(channel::SPEECH, sentences[sentence::PRESENTATION_1]);
+    plan.start(clock::now());
+
+    // keep lingering until the thread is stopped if no mic is found
+    hasNextState = true;
+    nextState = usingMic ? state::LISTEN : state::FOLLOW;
 
-    enum class answers { ANSWER_1, ANSWER_2, ANSWER_3 };
-    auto answer = answers::ANSWER_1;
+    while (!yarp::os::Thread::isStopping())
+    {
+        advance();
 
-    std::string listened;
+        auto deadline = std::min({*std::min_element(timers.cbegin(), timers.cend()),
+                                  plan.nextDeadline(ACTION_TIMEOUT, isSpeaking),
+                                  clock::now() + STOP_CHECK_PERIOD});
 
-    if (!usingMic)
+        if (event_t event; events.pop(event, deadline))
+        {
+            processEvent(event);
+        }
+
+        processTimers(clock::now());
+    }
+}
+
+void FollowMeDialogueManager::processEvent(const event_t & event)
+{
+    switch (event.type)
     {
-        // override state machine if no mic found, keep lingering until thread is stopped
-        armCommander.doGreet();
-        headCommander.enableFollowing();
-        ttsSayAndWait(sentence::FOLLOW);
-        asrListenAndLinger(); // this will loop indefinitely
+    case event_type::SPEECH:
+        processSpeech(event.text, event.arrival);
+        break;
+
+    case event_type::ZONE:
+        headZone = event.headZone; // announced once idle
+        break;
+
+    case event_type::ACTION:
+        processAction(event.action);
+        break;
     }
+}
 
-    while (!yarp::os::Thread::isStopping())
+void FollowMeDialogueManager::processSpeech(const std::string & text, clock::time_point heard)
+{
+    if (isSpeaking || isMicMuted || (machineState != state::LISTEN && machineState != state::DIALOGUE))
+    {
+        yDebug() << "Ignoring speech while not listening:" << text;
+        return;
+    }
+
+    turn = {heard, clock::now(), {}, {}};
+    isTurnActive = true;
+
+    auto match = matcher.match(text, minMatchScore); // a garbled utterance is better not understood than misunderstood
+    auto isHeard = [&match](command c) { return match.id == static_cast<int>(c); };
+
+    yDebug() << "Listened:" << text << "|| command score:" << match.score;
+
+    if (machineState == state::DIALOGUE)
     {
-        switch (machineState)
+        if (isHeard(command::STOP_FOLLOWING))
         {
-        case state::PRESENTATION:
-            ttsSayAndWait(sentence::PRESENTATION_2);
-            ttsSayAndWait(sentence::PRESENTATION_3);
-            machineState = state::LISTEN;
-            break;
+            enterState(state::STOP_FOLLOWING);
+        }
+        else if (isHeard(command::MY_NAME_IS))
+        {
+            clearPlan();
+            plan.add(channel::SPEECH, sentences[answers[nextAnswer]]);
+            plan.start(clock::now());
+            nextAnswer = (nextAnswer + 1) % answers.size();
+            hasNextState = true;
+            nextState = state::LISTEN;
+        }
+        else
+        {
+            clearPlan();
+            plan.add(channel::SPEECH, sentences[sentence::NOT_UNDERSTAND]);
+            plan.start(clock::now());
+            hasNextState = true;
+            nextState = state::ASK_NAME;
+        }
+    }
+    else
+    {
+        if (isHeard(command::HI_TEO))
+            enterState(state::PRESENTATION);
+        else if (isHeard(command::FOLLOW_ME))
+            enterState(state::FOLLOW);
+        else if (isHeard(command::STOP_FOLLOWING))
+            enterState(state::STOP_FOLLOWING);
+    }
 
-        case state::ASK_NAME:
-            armCommander.doGreet();
-            ttsSayAndWait(sentence::ASK_NAME);
-            machineState = state::DIALOGUE;
+    launchSteps();
+    turn.commanded = clock::now();
+}
+
+void FollowMeDialogueManager::processAction(const ActionEvent & event)
+{
+    if (event.status == ActionStatus::FAILED)
+    {
+        yWarning() << "Action" << event.action << "failed on" << event.part;
+    }
+
+    auto source = event.part == "head" ? channel::HEAD : channel::ARMS;
+    plan.processEvent(source, event.action, event.status == ActionStatus::STARTED, clock::now());
+}
+
+void FollowMeDialogueManager::processTimers(clock::time_point now)
+{
+    if (auto & deadline = timers[static_cast<std::size_t>(timer::SAY_POLL)]; now >= deadline)
+    {
+        deadline = clock::time_point::max();
+
+        if (yarp::os::Thread::isStopping() || tts.checkSayDone())
+        {
+            onSayDone(now);
+        }
+        else
+        {
+            deadline = now + SAY_POLL_PERIOD;
+        }
+    }
+
+    if (auto & deadline = timers[static_cast<std::size_t>(timer::UNMUTE)]; now >= deadline)
+    {
+        deadline = clock::time_point::max();
+        setMicrophone(false);
+    }
+
+    for (int step; (step = plan.findExpired(now - ACTION_TIMEOUT)) != ActionPlan::NONE;)
+    {
+        yWarning() << "Timed out while waiting for action" << plan.getStep(step).what;
+        plan.markDone(step, now);
+    }
+}
+
+void FollowMeDialogueManager::enterState(state next)
+{
+    machineState = next;
+    hasNextState = false;
+    clearPlan();
+
+    switch (next)
+    {
+    case state::PRESENTATION:
+    {
+        auto intro = plan.add(channel::SPEECH, sentences[sentence::PRESENTATION_2]);
+        plan.add(channel::ARMS, "greet", intro, sync::AFTER_START, GREET_DELAY);
+        plan.add(channel::SPEECH, sentences[sentence::PRESENTATION_3], intro, sync::AFTER_END);
+        hasNextState = true;
+        nextState = state::LISTEN;
+        break;
+    }
+
+    case state::ASK_NAME:
+        plan.add(channel::SPEECH, sentences[sentence::ASK_NAME]);
+        plan.add(channel::ARMS, "greet"); // listen once the arm is down
+        hasNextState = true;
+        nextState = state::DIALOGUE;
+        break;
+
+    case state::DIALOGUE:
+    case state::LISTEN:
+        break; // wait for the user
+
+    case state::FOLLOW:
+        plan.add(channel::HEAD, "follow", ActionPlan::NONE, sync::AFTER_START, {}, true);
+        plan.add(channel::SPEECH, sentences[sentence::FOLLOW]);
+
+        if (!usingMic)
+        {
+            plan.add(channel::ARMS, "greet");
+        }
+
+        isFollowing = true;
+        hasNextState = true;
+        nextState = usingMic ? state::ASK_NAME : state::LISTEN;
+        break;
+
+    case state::STOP_FOLLOWING:
+        plan.add(channel::ARMS, "home"); // quit swinging
+        plan.add(channel::HEAD, "home");
+        plan.add(channel::SPEECH, sentences[sentence::STOP_FOLLOWING]);
+        isFollowing = false;
+        hasNextState = true;
+        nextState = state::LISTEN;
+        break;
+    }
+
+    plan.start(clock::now());
+}
+
+void FollowMeDialogueManager::advance()
+{
+    launchSteps();
+
+    while (plan.isDone() && hasNextState)
+    {
+        enterState(nextState);
+        launchSteps();
+    }
+
+    if (!plan.isDone())
+    {
+        return;
+    }
+
+    // nothing else to do, wait for the user
+    finishTurn(clock::now());
+
+    if (machineState == state::LISTEN && isFollowing && headZone != announcedZone)
+    {
+        announceZone();
+        launchSteps();
+    }
+}
+
+void FollowMeDialogueManager::announceZone()
+{
+    announcedZone = headZone;
+    clearPlan();
+
+    switch (headZone)
+    {
+    case zone::LEFT:
+        plan.add(channel::ARMS, "signalLeft");
+        plan.add(channel::SPEECH, sentences[sentence::ON_THE_LEFT]);
+        break;
+    case zone::RIGHT:
+        plan.add(channel::ARMS, "signalRight");
+        plan.add(channel::SPEECH, sentences[sentence::ON_THE_RIGHT]);
+        break;
+    case zone::CENTER:
+        plan.add(channel::SPEECH, sentences[sentence::ON_THE_CENTER]);
+        break;
+    case zone::UNKNOWN:
+        break;
+    }
+
+    plan.start(clock::now());
+}
+
+void FollowMeDialogueManager::clearPlan()
+{
+    plan.clear();
+    speechStep = ActionPlan::NONE; // an ongoing sentence is left to finish on its own
+}
+
+void FollowMeDialogueManager::launchSteps()
+{
+    for (int step; (step = plan.nextDue(clock::now(), isSpeaking)) != ActionPlan::NONE;)
+    {
+        const auto & s = plan.getStep(step);
+        plan.markStarted(step, clock::now());
+
+        switch (s.target)
+        {
+        case channel::SPEECH:
+            if (speak(s.what))
+            {
+                speechStep = step;
+            }
+            else
+            {
+                plan.markDone(step, clock::now());
+            }
             break;
 
-        case state::DIALOGUE:
-            listened = asrListenAndWait();
+        case channel::ARMS:
+            if (!armCommander.playGesture(s.what))
+            {
+                yWarning() << "Failed to play gesture" << s.what;
+                plan.markDone(step, clock::now());
+            }
+            break;
 
-            if (listened.find(voiceCommands[command::STOP_FOLLOWING]) != std::string::npos)
+        case channel::HEAD:
+            if (s.what == "follow")
             {
-                machineState = state::STOP_FOLLOWING;
+                headCommander.enableFollowing();
             }
-            else if (listened.find(voiceCommands[command::MY_NAME_IS]) != std::string::npos)
+            else if (s.what == "home")
             {
-                switch (answer)
-                {
-                case answers::ANSWER_1:
-                    ttsSayAndWait(sentence::ANSWER_1);
-                    answer = answers::ANSWER_2;
-                    break;
-                case answers::ANSWER_2:
-                    ttsSayAndWait(sentence::ANSWER_2);
-                    answer = answers::ANSWER_3;
-                    break;
-                case answers::ANSWER_3:
-                    ttsSayAndWait(sentence::ANSWER_3);
-                    answer = answers::ANSWER_1;
-                    break;
-                }
-
-                machineState = state::LISTEN;
+                headCommander.disableFollowing();
             }
             else
             {
-                ttsSayAndWait(sentence::NOT_UNDERSTAND);
-                machineState = state::ASK_NAME;
+                yWarning() << "Unknown head action:" << s.what;
+                plan.markDone(step, clock::now());
             }
-
             break;
+        }
+    }
+}
 
-        case state::LISTEN:
-            listened = isFollowing ? asrListenAndLinger() : asrListenAndWait();
-
-            if (listened.find(voiceCommands[command::HI_TEO]) != std::string::npos)
-                machineState = state::PRESENTATION;
-            else if (listened.find(voiceCommands[command::FOLLOW_ME]) != std::string::npos)
-                machineState = state::FOLLOW;
-            else if (listened.find(voiceCommands[command::STOP_FOLLOWING]) != std::string::npos)
-                machineState = state::STOP_FOLLOWING;
-            else
-                machineState = state::LISTEN;
+bool FollowMeDialogueManager::speak(const std::string & text)
+{
+    setMicrophone(true); // stays muted if already talking
 
-            break;
+    if (!tts.say(text))
+    {
+        yWarning() << "Failed to say:" << text;
+        timers[static_cast<std::size_t>(timer::UNMUTE)] = clock::now();
+        return false;
+    }
 
-        case state::FOLLOW:
-            headCommander.enableFollowing();
-            ttsSayAndWait(sentence::FOLLOW);
-            machineState = state::ASK_NAME;
-            isFollowing = true;
-            break;
+    yDebug() << "Now saying:" << text;
+    isSpeaking = true;
+    sayStart = clock::now();
+    timers[static_cast<std::size_t>(timer::SAY_POLL)] = sayStart + SAY_POLL_PERIOD;
+    return true;
+}
 
-        case state::STOP_FOLLOWING:
-            armCommander.disableArmSwinging();
-            headCommander.disableFollowing();
-            ttsSayAndWait(sentence::STOP_FOLLOWING);
-            machineState = state::LISTEN;
-            isFollowing = false;
-            break;
-        }
+void FollowMeDialogueManager::onSayDone(clock::time_point now)
+{
+    isSpeaking = false;
+    turn.speaking += now - sayStart;
+
+    if (speechStep != ActionPlan::NONE)
+    {
+        plan.markDone(speechStep, now);
+        speechStep = ActionPlan::NONE;
+    }
+
+    // unmuted unless the next sentence comes right away
+    timers[static_cast<std::size_t>(timer::UNMUTE)] = now + ECHO_GUARD;
+}
 
-        yarp::os::SystemClock::delaySystem(0.5);
+void FollowMeDialogueManager::setMicrophone(bool mute)
+{
+    timers[static_cast<std::size_t>(timer::UNMUTE)] = clock::time_point::max();
+
+    if (!usingMic || mute == isMicMuted)
+    {
+        return;
+    }
+
+    if (mute ? !asr.muteMicrophone() : !asr.unmuteMicrophone())
+    {
+        yWarning() << "Failed to" << (mute ? "mute" : "unmute") << "microphone";
     }
+
+    isMicMuted = mute;
+}
+
+void FollowMeDialogueManager::finishTurn(clock::time_point now)
+{
+    if (!isTurnActive)
+    {
+        return;
+    }
+
+    using ms = std::chrono::duration<double, std::milli>;
+
+    yInfo() << "Turn latency: dispatch" << ms(turn.dispatched - turn.heard).count() << "ms | reaction"
+            << ms(turn.commanded - turn.dispatched).count() << "ms | speech" << ms(turn.speaking).count()
+            << "ms | settling" << ms(now - turn.commanded - turn.speaking).count() << "ms | total"
+            << ms(now - turn.heard).count() << "ms";
+
+    isTurnActive = false;
 }
 
 std::tuple<bool, std::string, std::string> FollowMeDialogueManager::checkOutputConnections()
@@ -384,106 +731,71 @@ std::tuple<bool, std::string, std::string> FollowMeDialogueManager::checkOutputC
         return {false, ttsClient.getName(), "TTS server"};
     }
 
-    if (usingMic && asrConfigClient.getOutputCount() == 0)
+    if (headZonePort.getInputCount() == 0)
     {
-        return {false, asrConfigClient.getName(), "ASR config server"};
+        return {false, headZonePort.getName(), "head zone publisher"};
     }
 
-    if (usingMic && inAsrPort.getInputCount() == 0)
+    if (armEventPort.getInputCount() == 0)
     {
-        return {false, inAsrPort.getName(), "ASR listener server"};
+        return {false, armEventPort.getName(), "arm event publisher"};
     }
 
-    return {true, {}, {}};
-}
-
-void FollowMeDialogueManager::ttsSayAndWait(sentence snt)
-{
-    if (usingMic && !asr.muteMicrophone())
+    if (headEventPort.getInputCount() == 0)
     {
-        yWarning() << "Failed to mute microphone";
+        return {false, headEventPort.getName(), "head event publisher"};
     }
 
-    if (auto sayString = sentences[snt]; !tts.say(sayString))
+    if (usingMic && asrConfigClient.getOutputCount() == 0)
     {
-        yWarning() << "Failed to say:" << sayString;
+        return {false, asrConfigClient.getName(), "ASR config server"};
     }
-    else
-    {
-        yDebug() << "Now saying:" << sayString;
 
-        do
-        {
-            yarp::os::SystemClock::delaySystem(0.1);
-        }
-        while (!yarp::os::Thread::isStopping() && !tts.checkSayDone());
+    if (usingMic && inAsrPort.getInputCount() == 0)
+    {
+        return {false, inAsrPort.getName(), "ASR listener server"};
     }
 
-    yarp::os::SystemClock::delaySystem(1.0); // more time due to ASR
+    return {true, {}, {}};
+}
 
-    if (usingMic && !asr.unmuteMicrophone())
+void FollowMeDialogueManager::onSpeech(yarp::os::Bottle & b)
+{
+    if (b.size() > 0)
     {
-        yWarning() << "Failed to unmute microphone";
+        events.push({event_type::SPEECH, clock::now(), b.get(0).asString(), {}, {}});
     }
 }
 
-std::string FollowMeDialogueManager::asrListenAndWait()
+void FollowMeDialogueManager::onZone(yarp::os::Bottle & b)
 {
-    const yarp::os::Bottle * b = nullptr;
+    auto description = b.get(0).asString();
+    auto newZone = zone::UNKNOWN;
 
-    while (!yarp::os::Thread::isStopping() && !b)
+    if (description == "left")
     {
-        b = inAsrPort.read(false); // don't block
-        yarp::os::SystemClock::delaySystem(0.1);
+        newZone = zone::LEFT;
     }
-
-    if (b && b->size() > 0)
+    else if (description == "center")
     {
-        auto text = b->get(0).asString();
-        yDebug() << "Listened:" << text;
-        return text;
+        newZone = zone::CENTER;
+    }
+    else if (description == "right")
+    {
+        newZone = zone::RIGHT;
+    }
+    else
+    {
+        yWarning() << "Unknown head zone event:" << b.toString();
+        return;
     }
 
-    return {};
+    yDebug() << "Head zone event:" << b.toString();
+    events.push({event_type::ZONE, clock::now(), {}, newZone, {}});
 }
 
-std::string FollowMeDialogueManager::asrListenAndLinger()
+void FollowMeDialogueManager::onAction(ActionEvent & event)
 {
-    enum class position { UNKNOWN, LEFT, CENTER, RIGHT };
-    auto pos = position::UNKNOWN;
-
-    while (!yarp::os::Thread::isStopping())
-    {
-        // don't wait
-        if (const auto * b = inAsrPort.read(false); b && b->size() > 0)
-        {
-            auto text = b->get(0).asString();
-            yDebug() << "Listened:" << text;
-            return text; // return as soon as something is heard
-        }
-
-        double encValue = headCommander.getOrientationAngle();
-
-        if (encValue > SIGNAL_THRESHOLD && pos != position::LEFT)
-        {
-            armCommander.doSignalLeft();
-            ttsSayAndWait(sentence::ON_THE_LEFT);
-            pos = position::LEFT;
-        }
-        else if (encValue < -SIGNAL_THRESHOLD && pos != position::RIGHT)
-        {
-            armCommander.doSignalRight();
-            ttsSayAndWait(sentence::ON_THE_RIGHT);
-            pos = position::RIGHT;
-        }
-        else if (encValue > -CENTER_THRESHOLD && encValue < CENTER_THRESHOLD && pos != position::CENTER)
-        {
-            ttsSayAndWait(sentence::ON_THE_CENTER);
-            pos = position::CENTER;
-        }
-
-        yarp::os::SystemClock::delaySystem(0.5);
-    }
-
-    return {};
+    yDebug() << "Action event:" << event.action << "on" << event.part << "with status" << static_cast<int>(event.status);
+    events.push({event_type::ACTION, clock::now(), {}, zone::UNKNOWN, event});
 }
@@ -3,6 +3,9 @@
 #ifndef __FOLLOW_ME_DIALOGUE_MANAGER_HPP__
 #define __FOLLOW_ME_DIALOGUE_MANAGER_HPP__
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -12,12 +15,17 @@
 #include <yarp/os/RFModule.h>
 #include <yarp/os/RpcClient.h>
 #include <yarp/os/Thread.h>
+#include <yarp/os/TypedReaderCallback.h>
 
 #include <SpeechSynthesis.h>
 #include <SpeechRecognition.h>
 
+#include "ActionEvent.h"
+#include "ActionPlan.hpp"
+#include "EventQueue.hpp"
 #include "FollowMeHeadCommands.h"
 #include "FollowMeArmCommands.h"
+#include "PhraseMatcher.hpp"
 
 namespace roboticslab
 {
@@ -25,6 +33,14 @@ namespace roboticslab
 /**
  * @ingroup followMeDialogueManager
  * @brief Dialogue Manager.
+ *
+ * The dialogue thread sleeps on a single event queue fed by the port callbacks
+ * (recognized speech, head zone changes, action events) and wakes up on its own
+ * timers, hence every transition happens as soon as its trigger arrives. Each
+ * state composes speech, gestures and head motions into an action plan that is
+ * executed concurrently, the state is left once the whole plan is done. The
+ * latency breakdown of each dialogue turn is logged. Voice commands are loaded
+ * from a language file, with several phrasings each.
  */
 class FollowMeDialogueManager : public yarp::os::RFModule,
                                 public yarp::os::Thread
@@ -48,10 +64,66 @@ public:
     void run() override;
 
 private:
+    using clock = std::chrono::steady_clock;
+
+    enum class zone { UNKNOWN, LEFT, CENTER, RIGHT };
+    enum class event_type { SPEECH, ZONE, ACTION };
+    enum class timer { SAY_POLL, UNMUTE, COUNT };
+
+    struct event_t
+    {
+        event_type type;
+        clock::time_point arrival;
+        std::string text; // recognized speech
+        zone headZone;
+        ActionEvent action;
+    };
+
+    struct turn_t
+    {
+        clock::time_point heard; // utterance received by the port callback
+        clock::time_point dispatched; // picked up by the dialogue thread
+        clock::time_point commanded; // reaction requested
+        clock::duration speaking; // accumulated speech time
+    };
+
+    // forwards data read from a port to a member function
+    template <typename T>
+    class PortCallback : public yarp::os::TypedReaderCallback<T>
+    {
+    public:
+        PortCallback(FollowMeDialogueManager & owner, void (FollowMeDialogueManager::*handler)(T &))
+            : owner(owner), handler(handler)
+        {}
+
+        void onRead(T & data) override
+        { (owner.*handler)(data); }
+
+    private:
+        FollowMeDialogueManager & owner;
+        void (FollowMeDialogueManager::*handler)(T &);
+    };
+
+    bool loadCommands(const std::string & path);
     std::tuple<bool, std::string, std::string> checkOutputConnections();
-    void ttsSayAndWait(sentence snt);
-    std::string asrListenAndWait();
-    std::string asrListenAndLinger();
+
+    void onSpeech(yarp::os::Bottle & b);
+    void onZone(yarp::os::Bottle & b);
+    void onAction(ActionEvent & event);
+
+    void processEvent(const event_t & event);
+    void processSpeech(const std::string & text, clock::time_point heard);
+    void processAction(const ActionEvent & event);
+    void processTimers(clock::time_point now);
+    void enterState(state next);
+    void advance();
+    void announceZone();
+    void clearPlan();
+    void launchSteps();
+    bool speak(const std::string & text);
+    void onSayDone(clock::time_point now);
+    void setMicrophone(bool mute);
+    void finishTurn(clock::time_point now);
 
     FollowMeArmCommands armCommander;
     FollowMeHeadCommands headCommander;
@@ -59,18 +131,44 @@ private:
     SpeechRecognition asr;
 
     yarp::os::BufferedPort<yarp::os::Bottle> inAsrPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> headZonePort;
+    yarp::os::BufferedPort<ActionEvent> armEventPort;
+    yarp::os::BufferedPort<ActionEvent> headEventPort;
     yarp::os::RpcClient ttsClient;
     yarp::os::RpcClient asrConfigClient;
     yarp::os::RpcClient headExecutionClient;
     yarp::os::RpcClient armExecutionClient;
 
+    PortCallback<yarp::os::Bottle> speechCallback {*this, &FollowMeDialogueManager::onSpeech};
+    PortCallback<yarp::os::Bottle> zoneCallback {*this, &FollowMeDialogueManager::onZone};
+    PortCallback<ActionEvent> actionCallback {*this, &FollowMeDialogueManager::onAction};
+
     std::string voice;
     std::string langCode;
     bool usingMic;
+    double minMatchScore;
     state machineState {state::LISTEN};
 
+    EventQueue<event_t> events;
+
+    // owned by the dialogue thread
+    std::array<clock::time_point, static_cast<std::size_t>(timer::COUNT)> timers;
+    ActionPlan plan;
+    int speechStep {ActionPlan::NONE};
+    bool isSpeaking {false};
+    bool isMicMuted {false};
+    clock::time_point sayStart;
+    bool hasNextState {false};
+    state nextState {state::LISTEN};
+    bool isFollowing {false};
+    zone headZone {zone::UNKNOWN};
+    zone announcedZone {zone::UNKNOWN};
+    std::size_t nextAnswer {0};
+    turn_t turn;
+    bool isTurnActive {false};
+
     std::unordered_map<sentence, std::string> sentences;
-    std::unordered_map<command, std::string> voiceCommands;
+    PhraseMatcher matcher; // compiled voice commands
 };
 
 } // namespace roboticslab
@@ -0,0 +1,299 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "PhraseMatcher.hpp"
+
+#include <cctype> // std::isalnum, std::tolower
+#include <cstdlib> // std::abs
+
+#include <algorithm> // std::lower_bound, std::max, std::min
+#include <deque>
+
+using namespace roboticslab;
+
+namespace
+{
+    // second byte of a two-byte UTF-8 sequence led by 0xC3 (Latin-1 supplement), zero if not a foldable letter
+    char foldAccent(unsigned char c)
+    {
+        c |= 0x20; // lowercase
+
+        if (c >= 0xA0 && c <= 0xA5) return 'a';
+        if (c == 0xA7) return 'c';
+        if (c >= 0xA8 && c <= 0xAB) return 'e';
+        if (c >= 0xAC && c <= 0xAF) return 'i';
+        if (c == 0xB1) return 'n';
+        if (c >= 0xB2 && c <= 0xB6) return 'o';
+        if (c >= 0xB9 && c <= 0xBC) return 'u';
+        return 0;
+    }
+
+    // allowed typos, short words must match exactly
+    int maxEdits(std::size_t length)
+    {
+        return length < 4 ? 0 : length < 8 ? 1 : 2;
+    }
+
+    // Levenshtein distance, any value above the bound means "too far"
+    int editDistance(const std::string & a, const std::string & b, int bound)
+    {
+        if (std::abs(static_cast<int>(a.size()) - static_cast<int>(b.size())) > bound)
+        {
+            return bound + 1;
+        }
+
+        std::vector<int> previous(b.size() + 1), current(b.size() + 1);
+
+        for (auto j = 0U; j <= b.size(); j++)
+        {
+            previous[j] = j;
+        }
+
+        for (auto i = 1U; i <= a.size(); i++)
+        {
+            current[0] = i;
+            auto rowMin = current[0];
+
+            for (auto j = 1U; j <= b.size(); j++)
+            {
+                auto substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+                rowMin = std::min(rowMin, current[j]);
+            }
+
+            if (rowMin > bound)
+            {
+                return bound + 1;
+            }
+
+            previous.swap(current);
+        }
+
+        return previous[b.size()];
+    }
+}
+
+bool PhraseMatcher::addPhrase(int id, const std::string & phrase)
+{
+    auto tokens = tokenize(phrase);
+
+    if (id < 0 || tokens.empty())
+    {
+        return false;
+    }
+
+    int node = 0;
+
+    for (const auto & token : tokens)
+    {
+        auto [it, isNew] = words.emplace(token, wordList.size());
+
+        if (isNew)
+        {
+            wordList.push_back(token);
+        }
+
+        auto child = findChild(node, it->second);
+
+        if (child < 0)
+        {
+            child = nodes.size();
+            nodes.emplace_back();
+
+            auto & next = nodes[node].next; // the reference is only valid after emplace_back
+            auto pos = std::lower_bound(next.begin(), next.end(), std::make_pair(it->second, 0));
+            next.insert(pos, {it->second, child});
+        }
+
+        node = child;
+    }
+
+    if (nodes[node].phrase >= 0)
+    {
+        return false; // duplicate
+    }
+
+    nodes[node].phrase = phrases.size();
+    phrases.push_back({id, tokens.size()});
+    return true;
+}
+
+void PhraseMatcher::compile()
+{
+    // breadth-first, failure links point to shallower nodes
+    std::deque<int> queue;
+
+    for (const auto & [word, child] : nodes[0].next)
+    {
+        nodes[child].fail = 0;
+        nodes[child].output = -1;
+        queue.push_back(child);
+    }
+
+    while (!queue.empty())
+    {
+        auto node = queue.front();
+        queue.pop_front();
+
+        for (const auto & [word, child] : nodes[node].next)
+        {
+            auto fail = nodes[node].fail;
+
+            while (fail != 0 && findChild(fail, word) < 0)
+            {
+                fail = nodes[fail].fail;
+            }
+
+            auto target = findChild(fail, word);
+            fail = target >= 0 ? target : 0;
+
+            nodes[child].fail = fail;
+            nodes[child].output = nodes[fail].phrase >= 0 ? fail : nodes[fail].output;
+            queue.push_back(child);
+        }
+    }
+}
+
+PhraseMatcher::match_t PhraseMatcher::match(const std::string & utterance, double minScore) const
+{
+    auto tokens = tokenize(utterance);
+    std::vector<double> similarities(tokens.size());
+
+    match_t best {NO_MATCH, 0.0};
+    double bestWeight = 0.0;
+    int state = 0;
+
+    for (auto i = 0U; i < tokens.size(); i++)
+    {
+        auto word = lookUp(tokens[i], similarities[i]);
+
+        if (word < 0)
+        {
+            state = 0; // no phrase spans an unknown word
+            continue;
+        }
+
+        while (state != 0 && findChild(state, word) < 0)
+        {
+            state = nodes[state].fail;
+        }
+
+        state = std::max(findChild(state, word), 0);
+
+        // every phrase that ends at this word
+        for (auto node = state; node > 0; node = nodes[node].output)
+        {
+            if (nodes[node].phrase < 0)
+            {
+                continue;
+            }
+
+            const auto & phrase = phrases[nodes[node].phrase];
+            double weight = 0.0;
+
+            for (auto j = i + 1 - phrase.length; j <= i; j++)
+            {
+                weight += similarities[j];
+            }
+
+            if (weight < minScore * phrase.length)
+            {
+                continue; // too garbled, a shorter or less fuzzy phrase may still do
+            }
+
+            if (weight > bestWeight)
+            {
+                bestWeight = weight;
+                best = {phrase.id, weight / phrase.length};
+            }
+        }
+    }
+
+    return best;
+}
+
+std::vector<std::string> PhraseMatcher::tokenize(const std::string & text)
+{
+    std::vector<std::string> tokens;
+    std::string token;
+
+    for (auto i = 0U; i < text.size(); i++)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+
+        if (c == 0xC3 && i + 1 < text.size())
+        {
+            if (auto folded = foldAccent(text[i + 1]); folded != 0)
+            {
+                token += folded;
+                i++;
+                continue;
+            }
+        }
+        else if (c == 0xC2 && i + 1 < text.size())
+        {
+            // Latin-1 punctuation and symbols, e.g. inverted question and exclamation marks
+            i++;
+
+            if (!token.empty())
+            {
+                tokens.push_back(std::move(token));
+                token.clear();
+            }
+
+            continue;
+        }
+
+        if (c >= 0x80 || std::isalnum(c))
+        {
+            token += std::tolower(c); // other non-ASCII bytes are kept as is
+        }
+        else if (c != '\'' && !token.empty()) // "don't" is one word
+        {
+            tokens.push_back(std::move(token));
+            token.clear();
+        }
+    }
+
+    if (!token.empty())
+    {
+        tokens.push_back(std::move(token));
+    }
+
+    return tokens;
+}
+
+int PhraseMatcher::findChild(int node, int word) const
+{
+    const auto & next = nodes[node].next;
+    auto it = std::lower_bound(next.begin(), next.end(), std::make_pair(word, 0));
+    return it != next.end() && it->first == word ? it->second : -1;
+}
+
+int PhraseMatcher::lookUp(const std::string & token, double & similarity) const
+{
+    if (auto it = words.find(token); it != words.end())
+    {
+        similarity = 1.0;
+        return it->second;
+    }
+
+    auto bound = maxEdits(token.size());
+    int best = -1;
+
+    for (auto i = 0U; i < wordList.size(); i++)
+    {
+        if (auto distance = editDistance(token, wordList[i], bound); distance <= bound)
+        {
+            best = i;
+            bound = distance - 1; // only a closer word may replace it
+            similarity = 1.0 - static_cast<double>(distance) / std::max(token.size(), wordList[i].size());
+        }
+    }
+
+    if (best < 0)
+    {
+        similarity = 0.0;
+    }
+
+    return best;
+}
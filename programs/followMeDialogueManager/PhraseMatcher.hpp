@@ -0,0 +1,75 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __PHRASE_MATCHER_HPP__
+#define __PHRASE_MATCHER_HPP__
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeDialogueManager
+ * @brief Finds the best matching phrase of a vocabulary in a single pass over an utterance.
+ *
+ * Phrases and utterances are normalized (lowercase, no punctuation nor accents) and
+ * split into words. All phrases are compiled once into an Aho-Corasick automaton
+ * over word identifiers, hence matching time does not depend on the number of
+ * phrases. Words unknown to the vocabulary are replaced by the closest known one
+ * within a small edit distance, which depends on the word length, so that minor
+ * recognition errors are tolerated.
+ */
+class PhraseMatcher
+{
+public:
+    static constexpr int NO_MATCH = -1;
+
+    struct match_t
+    {
+        int id; // as given to addPhrase, NO_MATCH if none was found
+        double score; // mean word similarity, 1.0 for an exact match
+    };
+
+    //! Register a phrase for the given non-negative identifier, several phrases may share one.
+    bool addPhrase(int id, const std::string & phrase);
+
+    //! Build the automaton, must be called after the last phrase was added.
+    void compile();
+
+    //! Best match in the utterance scoring at least the given threshold, longer and more accurate phrases win.
+    match_t match(const std::string & utterance, double minScore = 0.0) const;
+
+    //! Lowercase words without punctuation nor accents.
+    static std::vector<std::string> tokenize(const std::string & text);
+
+private:
+    struct node_t
+    {
+        std::vector<std::pair<int, int>> next; // (word, node), sorted by word
+        int fail {0};
+        int phrase {-1}; // ending here
+        int output {-1}; // next node along the failure chain that ends a phrase
+    };
+
+    struct phrase_t
+    {
+        int id;
+        std::size_t length; // [words]
+    };
+
+    int findChild(int node, int word) const;
+    int lookUp(const std::string & token, double & similarity) const;
+
+    std::unordered_map<std::string, int> words;
+    std::vector<std::string> wordList;
+    std::vector<phrase_t> phrases;
+    std::vector<node_t> nodes {1}; // root first
+};
+
+} // namespace roboticslab
+
+#endif // __PHRASE_MATCHER_HPP__
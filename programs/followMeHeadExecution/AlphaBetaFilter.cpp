@@ -0,0 +1,48 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "AlphaBetaFilter.hpp"
+
+using namespace roboticslab;
+
+void AlphaBetaFilter::update(double timestamp, const vector_t & measurement, double weight)
+{
+    if (!initialized)
+    {
+        position = measurement;
+        velocity = {0.0, 0.0};
+        residual = {0.0, 0.0};
+        lastTimestamp = timestamp;
+        initialized = true;
+        return;
+    }
+
+    auto dt = timestamp - lastTimestamp;
+    auto predicted = predict(timestamp);
+
+    for (auto i = 0U; i < position.size(); i++)
+    {
+        residual[i] = measurement[i] - predicted[i];
+
+        if (dt > 0.0)
+        {
+            position[i] = predicted[i] + weight * alpha * residual[i];
+            velocity[i] += weight * beta * residual[i] / dt;
+        }
+        else
+        {
+            // late (out-of-order) measurement, only nudge the current estimate
+            position[i] += weight * alpha * residual[i];
+        }
+    }
+
+    if (dt > 0.0)
+    {
+        lastTimestamp = timestamp;
+    }
+}
+
+AlphaBetaFilter::vector_t AlphaBetaFilter::predict(double timestamp) const
+{
+    auto dt = timestamp - lastTimestamp;
+    return {position[0] + velocity[0] * dt, position[1] + velocity[1] * dt};
+}
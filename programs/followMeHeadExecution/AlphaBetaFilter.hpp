@@ -0,0 +1,66 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __ALPHA_BETA_FILTER_HPP__
+#define __ALPHA_BETA_FILTER_HPP__
+
+#include <array>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Constant-velocity alpha-beta tracker for the target bearing in head joint space.
+ *
+ * Measurements are stamped with their capture time, predictions can be queried for
+ * any later instant to compensate for detection and transport latency.
+ */
+class AlphaBetaFilter
+{
+public:
+    using vector_t = std::array<double, 2>;
+
+    AlphaBetaFilter(double alpha = 1.0, double beta = 0.0)
+        : alpha(alpha), beta(beta)
+    {}
+
+    //! Forget the current estimate.
+    void reset()
+    { initialized = false; }
+
+    //! Correct the estimate with a measurement taken at the given instant, scaled by its weight in (0, 1].
+    void update(double timestamp, const vector_t & measurement, double weight = 1.0);
+
+    //! Extrapolate the estimate to the given instant.
+    vector_t predict(double timestamp) const;
+
+    bool isInitialized() const
+    { return initialized; }
+
+    double getTimestamp() const
+    { return lastTimestamp; }
+
+    const vector_t & getPosition() const
+    { return position; }
+
+    const vector_t & getVelocity() const
+    { return velocity; }
+
+    //! Innovation of the last update (measurement minus prediction).
+    const vector_t & getResidual() const
+    { return residual; }
+
+private:
+    double alpha;
+    double beta;
+
+    bool initialized {false};
+    double lastTimestamp {0.0};
+    vector_t position {0.0, 0.0};
+    vector_t velocity {0.0, 0.0};
+    vector_t residual {0.0, 0.0};
+};
+
+} // namespace roboticslab
+
+#endif // __ALPHA_BETA_FILTER_HPP__
@@ -0,0 +1,329 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "DetectionSource.hpp"
+
+#include <cmath> // std::atan2, std::lround, std::tan
+
+#include <algorithm> // std::clamp, std::min
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+
+using namespace roboticslab;
+
+constexpr auto DETECTION_PROTOCOL_VERSION = 1;
+constexpr auto RAD_TO_DEG = 180.0 / 3.14159265358979323846;
+constexpr auto DEG_TO_RAD = 1.0 / RAD_TO_DEG;
+
+bool DetectionSource::configure(const yarp::os::Searchable & options, const std::array<double, 3> & defaultOffset,
+                                const std::array<double, 4> & defaultIntrinsics, double defaultTimeout)
+{
+    cameraOffset = defaultOffset;
+    intrinsics = defaultIntrinsics;
+    weight = options.check("weight", yarp::os::Value(1.0), "trust in this source").asFloat64();
+    timeout = options.check("timeout", yarp::os::Value(defaultTimeout), "max expected latency and frame interval [s]").asFloat64();
+
+    if (options.check("cameraOffset", "position of the camera wrt. the head rotation center [m]"))
+    {
+        const auto * offsets = options.find("cameraOffset").asList();
+
+        if (!offsets || offsets->size() != cameraOffset.size())
+        {
+            yError() << "Parameter cameraOffset of source" << name << "must be a list of" << cameraOffset.size() << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < cameraOffset.size(); i++)
+        {
+            cameraOffset[i] = offsets->get(i).asFloat64();
+        }
+    }
+
+    if (options.check("cameraOrientation", "(pan tilt) of the camera optical axis wrt. the head [deg]"))
+    {
+        const auto * angles = options.find("cameraOrientation").asList();
+
+        if (!angles || angles->size() != cameraOrientation.size())
+        {
+            yError() << "Parameter cameraOrientation of source" << name << "must be a list of" << cameraOrientation.size() << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < cameraOrientation.size(); i++)
+        {
+            cameraOrientation[i] = angles->get(i).asFloat64();
+        }
+    }
+
+    if (options.check("intrinsics", "(fx fy cx cy) of the camera [px]"))
+    {
+        const auto * values = options.find("intrinsics").asList();
+
+        if (!values || values->size() != intrinsics.size())
+        {
+            yError() << "Parameter intrinsics of source" << name << "must be a list of" << intrinsics.size() << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < intrinsics.size(); i++)
+        {
+            intrinsics[i] = values->get(i).asFloat64();
+        }
+    }
+
+    if (intrinsics[0] < 0.0 || intrinsics[1] < 0.0 || (intrinsics[0] == 0.0) != (intrinsics[1] == 0.0))
+    {
+        yError() << "Focal lengths of source" << name << "must be both positive (or both zero if unknown)";
+        return false;
+    }
+
+    if (weight <= 0.0 || weight > 1.0)
+    {
+        yError() << "Weight of source" << name << "must lie in (0, 1], got:" << weight;
+        return false;
+    }
+
+    if (timeout <= 0.0)
+    {
+        yError() << "Timeout of source" << name << "must be positive, got:" << timeout;
+        return false;
+    }
+
+    return true;
+}
+
+bool DetectionSource::open(const std::string & prefix, bool withLegacyPort)
+{
+    if (!listPort.open(prefix + "/detections:i"))
+    {
+        yError() << "Failed to open detection list client port" << listPort.getName();
+        return false;
+    }
+
+    if (withLegacyPort && !legacyPort.open(prefix + "/state:i"))
+    {
+        yError() << "Failed to open detection client port" << legacyPort.getName();
+        return false;
+    }
+
+    hasLegacyPort = withLegacyPort;
+
+    if (intrinsics[0] > 0.0 && !roiPort.open(prefix + "/roi:o"))
+    {
+        yError() << "Failed to open region of interest port" << roiPort.getName();
+        return false;
+    }
+
+    hasRoiPort = intrinsics[0] > 0.0;
+
+    listPort.useCallback(static_cast<yarp::os::TypedReaderCallback<DetectionList> &>(*this));
+
+    if (hasLegacyPort)
+    {
+        legacyPort.useCallback(static_cast<yarp::os::TypedReaderCallback<yarp::os::Bottle> &>(*this));
+    }
+
+    return true;
+}
+
+void DetectionSource::interrupt()
+{
+    listPort.interrupt();
+    listPort.disableCallback();
+
+    if (hasRoiPort)
+    {
+        roiPort.interrupt();
+    }
+
+    if (hasLegacyPort)
+    {
+        legacyPort.interrupt();
+        legacyPort.disableCallback();
+    }
+}
+
+void DetectionSource::close()
+{
+    listPort.close();
+
+    if (hasRoiPort)
+    {
+        roiPort.close();
+    }
+
+    if (hasLegacyPort)
+    {
+        legacyPort.close();
+    }
+}
+
+bool DetectionSource::isConnected()
+{
+    return listPort.getInputCount() != 0 || (hasLegacyPort && legacyPort.getInputCount() != 0);
+}
+
+void DetectionSource::onRead(yarp::os::Bottle & b)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    received++;
+
+    if (b.size() != 3)
+    {
+        yWarning() << "InCvPort protocol error, expected 3 elements, got" << b.size();
+        dropped++;
+        return;
+    }
+
+    // legacy protocol: a single (x y z) detection without metadata
+    frame_t frame;
+    frame.timestamp = resolveCaptureTime(legacyPort, lastLegacyCount, 0.0);
+    frame.count = 1;
+    frame.detections[0] = {-1, b.get(0).asFloat64(), b.get(1).asFloat64(), b.get(2).asFloat64(), 1.0, {0, 0, 0, 0}};
+
+    legacyMailbox.write(frame);
+}
+
+void DetectionSource::onRead(DetectionList & detections)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    received++;
+
+    if (detections.version != DETECTION_PROTOCOL_VERSION)
+    {
+        yWarning() << "Unsupported detection protocol version" << detections.version << "expected" << DETECTION_PROTOCOL_VERSION;
+        dropped++;
+        return;
+    }
+
+    if (detections.detections.size() > MAX_DETECTIONS)
+    {
+        yWarningThrottle(1.0) << "Got" << detections.detections.size() << "detections, only the first" << MAX_DETECTIONS << "will be considered";
+    }
+
+    frame_t frame;
+    frame.timestamp = resolveCaptureTime(listPort, lastListCount, detections.timestamp);
+    frame.count = std::min(detections.detections.size(), MAX_DETECTIONS);
+
+    for (auto i = 0U; i < frame.count; i++)
+    {
+        const auto & d = detections.detections[i];
+        frame.detections[i] = {d.id, d.x, d.y, d.z, d.confidence, {d.box.x, d.box.y, d.box.width, d.box.height}};
+    }
+
+    listMailbox.write(frame);
+}
+
+double DetectionSource::resolveCaptureTime(yarp::os::Contactable & port, int & lastCount, double sourceTime)
+{
+    auto arrival = yarp::os::Time::now();
+
+    if (yarp::os::Stamp stamp; port.getEnvelope(stamp) && stamp.isValid())
+    {
+        // gaps in the sequence number reveal frames lost by the port itself
+        if (lastCount >= 0 && stamp.getCount() > lastCount + 1)
+        {
+            dropped += stamp.getCount() - lastCount - 1;
+        }
+
+        lastCount = stamp.getCount();
+
+        if (sourceTime <= 0.0)
+        {
+            sourceTime = stamp.getTime();
+        }
+    }
+
+    // don't trust the sender's clock if it is obviously out of sync with ours
+    if (auto latency = arrival - sourceTime; sourceTime > 0.0 && latency >= 0.0 && latency < timeout)
+    {
+        return sourceTime;
+    }
+
+    return arrival;
+}
+
+bool DetectionSource::computeBearing(double x, double y, double z, std::array<double, 2> & bearing) const
+{
+    // Shift the detection to the head rotation center so that the resulting angles
+    // are the actual joint displacements needed to center the target.
+    x += cameraOffset[0];
+    y += cameraOffset[1];
+    z += cameraOffset[2];
+
+    if (z <= 0.0)
+    {
+        return false;
+    }
+
+    // On the received frame, positive X is to the right, positive Y is down.
+    // First axis (global Z roll) is positive to the left (frame-wise).
+    // Second axis (global Y pitch) is positive down (frame-wise).
+    // Cameras mounted off the head's optical axis add their own (small) angular offset.
+    bearing[0] = cameraOrientation[0] - std::atan2(x, z) * RAD_TO_DEG;
+    bearing[1] = cameraOrientation[1] + std::atan2(y, z) * RAD_TO_DEG;
+    return true;
+}
+
+bool DetectionSource::projectBearing(const std::array<double, 2> & bearing, double z, std::array<double, 2> & pixel) const
+{
+    auto depth = z + cameraOffset[2]; // wrt. the head rotation center
+
+    if (z <= 0.0 || depth <= 0.0)
+    {
+        return false;
+    }
+
+    auto pan = (cameraOrientation[0] - bearing[0]) * DEG_TO_RAD;
+    auto tilt = (bearing[1] - cameraOrientation[1]) * DEG_TO_RAD;
+
+    // back to the camera frame
+    auto x = depth * std::tan(pan) - cameraOffset[0];
+    auto y = depth * std::tan(tilt) - cameraOffset[1];
+
+    pixel[0] = intrinsics[2] + intrinsics[0] * x / z;
+    pixel[1] = intrinsics[3] + intrinsics[1] * y / z;
+    return true;
+}
+
+void DetectionSource::publishRegionOfInterest(double timestamp, int targetId, const std::array<double, 4> & box)
+{
+    // keep the region within the image, assuming the principal point lies at its center
+    auto left = std::clamp(box[0], 0.0, 2.0 * intrinsics[2]);
+    auto top = std::clamp(box[1], 0.0, 2.0 * intrinsics[3]);
+    auto right = std::clamp(box[0] + box[2], 0.0, 2.0 * intrinsics[2]);
+    auto bottom = std::clamp(box[1] + box[3], 0.0, 2.0 * intrinsics[3]);
+
+    RegionOfInterest & roi = roiPort.prepare();
+    roi.timestamp = timestamp;
+    roi.targetId = targetId;
+    roi.box.x = std::lround(left);
+    roi.box.y = std::lround(top);
+    roi.box.width = std::lround(right - left);
+    roi.box.height = std::lround(bottom - top);
+    roiPort.setEnvelope(yarp::os::Stamp(++roiCount, timestamp));
+    roiPort.write();
+
+    isRegionOfInterestActive = true;
+}
+
+void DetectionSource::clearRegionOfInterest(double timestamp)
+{
+    RegionOfInterest & roi = roiPort.prepare();
+    roi.timestamp = timestamp;
+    roi.targetId = -1;
+    roi.box = BoundingBox();
+    roiPort.setEnvelope(yarp::os::Stamp(++roiCount, timestamp));
+    roiPort.writeStrict(); // must not be superseded
+
+    isRegionOfInterestActive = false;
+}
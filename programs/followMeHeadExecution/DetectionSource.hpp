@@ -0,0 +1,161 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __DETECTION_SOURCE_HPP__
+#define __DETECTION_SOURCE_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Searchable.h>
+#include <yarp/os/TypedReaderCallback.h>
+
+#include "DetectionList.h"
+#include "LatestValueMailbox.hpp"
+#include "RegionOfInterest.h"
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief A single detector (camera) feeding the head tracker.
+ *
+ * Owns the input ports of one detector and its extrinsics relative to the head
+ * rotation center. Frames received by the port callbacks are handed over to the
+ * control thread through latest-value mailboxes, one per port. If the camera
+ * intrinsics are known, the region of interest of the followed target in the next
+ * frame is fed back to the detector.
+ */
+class DetectionSource : public yarp::os::TypedReaderCallback<yarp::os::Bottle>,
+                        public yarp::os::TypedReaderCallback<DetectionList>
+{
+public:
+    static constexpr std::size_t MAX_DETECTIONS = 16;
+
+    struct detection_t
+    {
+        int id;
+        double x; // [m]
+        double y; // [m]
+        double z; // [m]
+        double confidence;
+        std::array<int, 4> box; // [px], (x y width height)
+    };
+
+    // fixed-size counterpart of DetectionList, cheap to copy across threads
+    struct frame_t
+    {
+        double timestamp; // [s], capture time
+        std::size_t count;
+        std::array<detection_t, MAX_DETECTIONS> detections;
+    };
+
+    DetectionSource(const std::string & name, const std::atomic_bool & enabled)
+        : name(name), enabled(enabled)
+    {}
+
+    //! Parse (cameraOffset (x y z)) (cameraOrientation (pan tilt)) (intrinsics (fx fy cx cy)) (weight w) (timeout t).
+    bool configure(const yarp::os::Searchable & options, const std::array<double, 3> & defaultOffset,
+                   const std::array<double, 4> & defaultIntrinsics, double defaultTimeout);
+
+    //! Open the detection list port, the legacy (x y z) port if requested, and the ROI port if intrinsics are known.
+    bool open(const std::string & prefix, bool withLegacyPort);
+
+    void interrupt();
+    void close();
+
+    void onRead(yarp::os::Bottle & b) override;
+    void onRead(DetectionList & detections) override;
+
+    //! Fetch new frames, if any, from the legacy and detection list ports.
+    bool readLegacyFrame(frame_t & frame)
+    { return legacyMailbox.read(frame); }
+
+    bool readFrame(frame_t & frame)
+    { return listMailbox.read(frame); }
+
+    //! Bearing of a detection wrt. the head joint position at capture time [deg].
+    bool computeBearing(double x, double y, double z, std::array<double, 2> & bearing) const;
+
+    //! Inverse of computeBearing() for a target at the given depth, yields image coordinates [px].
+    bool projectBearing(const std::array<double, 2> & bearing, double z, std::array<double, 2> & pixel) const;
+
+    //! Send the expected (x y width height) region of the target in the frame captured at the given instant.
+    void publishRegionOfInterest(double timestamp, int targetId, const std::array<double, 4> & box);
+
+    //! Tell the detector to scan full frames again.
+    void clearRegionOfInterest(double timestamp);
+
+    bool hasRegionOfInterestPort() const
+    { return hasRoiPort; }
+
+    bool isConnected();
+
+    const std::string & getName() const
+    { return name; }
+
+    double getWeight() const
+    { return weight; }
+
+    double getTimeout() const
+    { return timeout; }
+
+    std::int64_t getReceived() const
+    { return received; }
+
+    std::int64_t getDropped() const
+    { return dropped; }
+
+    std::int64_t getSuperseded() const
+    { return legacyMailbox.getSuperseded() + listMailbox.getSuperseded(); }
+
+    void addDropped()
+    { dropped++; }
+
+    // owned by the control thread
+    double lastFrameTime {0.0};
+    bool isStalled {false};
+    double lastCaptureTime {0.0};
+    double frameInterval {0.0}; // [s], smoothed
+    int followedId {-1}; // last followed target seen by this source
+    double followedDepth {0.0}; // [m]
+    std::array<int, 4> followedBox {0, 0, 0, 0};
+    bool isRegionOfInterestActive {false};
+
+private:
+    double resolveCaptureTime(yarp::os::Contactable & port, int & lastCount, double sourceTime);
+
+    std::string name;
+    const std::atomic_bool & enabled;
+
+    std::array<double, 3> cameraOffset {0.0, 0.0, 0.0}; // [m]
+    std::array<double, 2> cameraOrientation {0.0, 0.0}; // [deg]
+    std::array<double, 4> intrinsics {0.0, 0.0, 0.0, 0.0}; // (fx fy cx cy) [px]
+    double weight {1.0};
+    double timeout {0.0}; // [s]
+
+    yarp::os::BufferedPort<yarp::os::Bottle> legacyPort;
+    yarp::os::BufferedPort<DetectionList> listPort;
+    yarp::os::BufferedPort<RegionOfInterest> roiPort;
+    bool hasLegacyPort {false};
+    bool hasRoiPort {false};
+    int roiCount {0};
+
+    // owned by the port callback threads
+    int lastLegacyCount {-1};
+    int lastListCount {-1};
+
+    LatestValueMailbox<frame_t> legacyMailbox;
+    LatestValueMailbox<frame_t> listMailbox;
+    std::atomic<std::int64_t> received {0};
+    std::atomic<std::int64_t> dropped {0};
+};
+
+} // namespace roboticslab
+
+#endif // __DETECTION_SOURCE_HPP__
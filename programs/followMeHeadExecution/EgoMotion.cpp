@@ -0,0 +1,74 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "EgoMotion.hpp"
+
+using namespace roboticslab;
+
+double EgoMotion::resolveTime(double arrival, double stamp, double maxLatency)
+{
+    // don't trust the sender's clock if it is obviously out of sync with ours, stamps from
+    // the future would also discard every sample that follows as out of order
+    if (auto latency = arrival - stamp; stamp > 0.0 && latency >= 0.0 && latency < maxLatency)
+    {
+        return stamp;
+    }
+
+    return arrival;
+}
+
+bool EgoMotion::addHeadSample(double timestamp, const vector_t & position)
+{
+    if (timestamp <= lastHeadTimestamp)
+    {
+        return false;
+    }
+
+    headHistory.push(timestamp, position);
+    lastHeadTimestamp = timestamp;
+    return true;
+}
+
+bool EgoMotion::addBaseSample(double timestamp, const vector_t & orientation)
+{
+    if (timestamp <= lastBaseTimestamp)
+    {
+        return false;
+    }
+
+    baseHistory.push(timestamp, orientation);
+    lastBaseTimestamp = timestamp;
+    return true;
+}
+
+EgoMotion::vector_t EgoMotion::getBaseOrientation(double timestamp) const
+{
+    vector_t orientation;
+
+    if (!baseHistory.interpolate(timestamp, orientation))
+    {
+        return {0.0, 0.0}; // no ego-motion stream, the world frame is the head base frame
+    }
+
+    return orientation;
+}
+
+EgoMotion::vector_t EgoMotion::getBaseRate(double timestamp, double window) const
+{
+    auto now = getBaseOrientation(timestamp);
+    auto past = getBaseOrientation(timestamp - window);
+    return {(now[0] - past[0]) / window, (now[1] - past[1]) / window};
+}
+
+bool EgoMotion::getCameraOrientation(double timestamp, vector_t & orientation) const
+{
+    vector_t head;
+
+    if (!headHistory.interpolate(timestamp, head))
+    {
+        return false;
+    }
+
+    auto base = getBaseOrientation(timestamp);
+    orientation = {base[0] + head[0], base[1] + head[1]};
+    return true;
+}
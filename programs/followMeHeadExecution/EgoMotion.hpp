@@ -0,0 +1,54 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __EGO_MOTION_HPP__
+#define __EGO_MOTION_HPP__
+
+#include <array>
+
+#include "InterpolationBuffer.hpp"
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Recent history of the head joints and of the world-frame orientation of the head base.
+ *
+ * Detections are stamped with their capture time, so the head and base poses are
+ * interpolated back to that instant in order to express them in the world frame.
+ * The base orientation is zero until the first sample arrives, hence the world frame
+ * is the head base frame if no ego-motion stream is available.
+ */
+class EgoMotion
+{
+public:
+    using vector_t = std::array<double, 2>;
+
+    //! Sender's stamp if plausible given the local arrival time, the arrival time otherwise.
+    static double resolveTime(double arrival, double stamp, double maxLatency);
+
+    //! Record the head joint positions [deg] at the given instant, returns false if out of order.
+    bool addHeadSample(double timestamp, const vector_t & position);
+
+    //! Record the (yaw pitch) orientation of the head base [deg] at the given instant, returns false if out of order.
+    bool addBaseSample(double timestamp, const vector_t & orientation);
+
+    //! World-frame orientation of the head base at the given instant.
+    vector_t getBaseOrientation(double timestamp) const;
+
+    //! Mean angular rate of the head base [deg/s] over the window that ends at the given instant.
+    vector_t getBaseRate(double timestamp, double window) const;
+
+    //! World-frame orientation of the camera axis at the given instant, false if the head was never sampled.
+    bool getCameraOrientation(double timestamp, vector_t & orientation) const;
+
+private:
+    InterpolationBuffer<2, 64> headHistory;
+    InterpolationBuffer<2, 64> baseHistory;
+    double lastHeadTimestamp {0.0};
+    double lastBaseTimestamp {0.0};
+};
+
+} // namespace roboticslab
+
+#endif // __EGO_MOTION_HPP__
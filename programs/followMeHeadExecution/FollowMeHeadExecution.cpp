@@ -2,13 +2,19 @@
 
 #include "FollowMeHeadExecution.hpp"
 
-#include <cmath> // std::abs, std::copysign
+#include <cmath> // std::abs, std::ceil, std::copysign
 
+#include <algorithm> // std::any_of, std::clamp, std::max, std::none_of, std::sort
 #include <array>
+#include <memory> // std::make_unique
+#include <numeric> // std::iota
+#include <string>
 #include <vector>
 
 #include <yarp/os/LogStream.h>
 #include <yarp/os/Property.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
 
 using namespace roboticslab;
 
@@ -16,20 +22,207 @@ constexpr auto DEFAULT_ROBOT = "/teo";
 constexpr auto DEFAULT_PREFIX = "/followMeHeadExecution";
 constexpr auto DEFAULT_REF_SPEED = 30.0;
 constexpr auto DEFAULT_REF_ACCELERATION = 30.0;
-constexpr auto DETECTION_DEADBAND = 0.03; // [m]
+constexpr auto DEFAULT_DEADBAND = 2.0; // [deg]
 constexpr auto RELATIVE_INCREMENT = 2.0; // [deg]
+constexpr auto DEFAULT_PERIOD = 0.02; // [s]
+constexpr auto DEFAULT_MODE = "step";
+constexpr auto DEFAULT_KP = 2.0; // [1/s]
+constexpr auto DEFAULT_KD = 0.0; // [s]
+constexpr auto DEFAULT_MAX_VELOCITY = 20.0; // [deg/s]
+constexpr auto DEFAULT_TRAJECTORY_DURATION = 0.4; // [s]
+constexpr auto DETECTION_TIMEOUT = 0.5; // [s]
+constexpr auto DEFAULT_SOURCE = "cv";
+constexpr auto DEFAULT_ALPHA = 0.6;
+constexpr auto DEFAULT_BETA = 0.2;
+constexpr auto DEFAULT_LOOKAHEAD = 0.05; // [s]
+constexpr auto DEFAULT_ASSOCIATION_GATE = 8.0; // [deg]
+constexpr auto TRACK_TIMEOUT = 1.0; // [s]
+constexpr auto EGOMOTION_RATE_WINDOW = 0.1; // [s]
+constexpr auto MAX_EGOMOTION_LATENCY = 0.2; // [s]
+constexpr auto MAX_ENCODER_LATENCY = 0.2; // [s]
+constexpr auto DEFAULT_ROI_SCALE = 1.5;
+constexpr auto FRAME_INTERVAL_SMOOTHING = 0.2;
+constexpr auto DEFAULT_SIGNAL_THRESHOLD = 10.0; // [deg]
+constexpr auto DEFAULT_CENTER_THRESHOLD = 3.0; // [deg]
+constexpr auto HOMING_CHECK_PERIOD = 0.1; // [s]
+
+constexpr auto MIN_JERK_PEAK_VELOCITY_RATIO = 1.875; // peak velocity times duration over distance
 
 constexpr std::array<double, 2> headZeros {0.0, 0.0};
 
+namespace
+{
+    void addVector(yarp::os::Bottle & b, const std::array<double, 2> & v)
+    {
+        yarp::os::Bottle & l = b.addList();
+        l.addFloat64(v[0]);
+        l.addFloat64(v[1]);
+    }
+}
+
+FollowMeHeadExecution::FollowMeHeadExecution()
+    : yarp::os::PeriodicThread(DEFAULT_PERIOD),
+      tracker(DEFAULT_ALPHA, DEFAULT_BETA, DEFAULT_ASSOCIATION_GATE, TRACK_TIMEOUT)
+{}
+
 bool FollowMeHeadExecution::configure(yarp::os::ResourceFinder &rf)
 {
     auto robot = rf.check("robot", yarp::os::Value(DEFAULT_ROBOT), "remote robot port prefix").asString();
+    auto period = rf.check("period", yarp::os::Value(DEFAULT_PERIOD), "control thread period [s]").asFloat64();
+    auto mode = rf.check("mode", yarp::os::Value(DEFAULT_MODE), "tracking mode (step, position, velocity, direct)").asString();
+    deadband = rf.check("deadband", yarp::os::Value(DEFAULT_DEADBAND), "angular deadband [deg]").asFloat64();
+    kp = rf.check("kp", yarp::os::Value(DEFAULT_KP), "proportional gain of velocity tracker [1/s]").asFloat64();
+    kd = rf.check("kd", yarp::os::Value(DEFAULT_KD), "derivative gain of velocity tracker [s]").asFloat64();
+    maxVelocity = rf.check("maxVelocity", yarp::os::Value(DEFAULT_MAX_VELOCITY), "velocity saturation of velocity and direct trackers [deg/s]").asFloat64();
+    trajectoryDuration = rf.check("trajectoryDuration", yarp::os::Value(DEFAULT_TRAJECTORY_DURATION), "min duration of direct mode trajectories [s]").asFloat64();
+    auto alpha = rf.check("alpha", yarp::os::Value(DEFAULT_ALPHA), "position gain of target filter").asFloat64();
+    auto beta = rf.check("beta", yarp::os::Value(DEFAULT_BETA), "velocity gain of target filter").asFloat64();
+    lookahead = rf.check("lookahead", yarp::os::Value(DEFAULT_LOOKAHEAD), "prediction horizon beyond command time [s]").asFloat64();
+    auto associationGate = rf.check("associationGate", yarp::os::Value(DEFAULT_ASSOCIATION_GATE), "max bearing distance between a detection and its track [deg]").asFloat64();
+    auto noPrediction = rf.check("noPrediction", "disable latency-compensated target prediction");
+    signalThreshold = rf.check("signalThreshold", yarp::os::Value(DEFAULT_SIGNAL_THRESHOLD), "pan angle beyond which the user is on a side [deg]").asFloat64();
+    roiScale = rf.check("roiScale", yarp::os::Value(DEFAULT_ROI_SCALE), "size of the predicted region of interest wrt. the last bounding box").asFloat64();
+    centerThreshold = rf.check("centerThreshold", yarp::os::Value(DEFAULT_CENTER_THRESHOLD), "pan angle below which the user is centered [deg]").asFloat64();
 
     if (rf.check("help"))
     {
         yInfo("FollowMeHeadExecution options:");
         yInfo("\t--help (this help)\t--from [file.ini]\t--context [path]");
         yInfo("\t--robot: %s [%s]", robot.c_str(), DEFAULT_ROBOT);
+        yInfo("\t--period: %f [%f]", period, DEFAULT_PERIOD);
+        yInfo("\t--mode: %s [%s]", mode.c_str(), DEFAULT_MODE);
+        yInfo("\t--deadband: %f [%f]", deadband, DEFAULT_DEADBAND);
+        yInfo("\t--cameraOffset: (x y z) position of the camera wrt. the head rotation center [m] [(0 0 0)]");
+        yInfo("\t--intrinsics: (fx fy cx cy) of the camera, enables region of interest feedback [px] [(0 0 0 0)]");
+        yInfo("\t--roiScale: %f [%f]", roiScale, DEFAULT_ROI_SCALE);
+        yInfo("\t--sources: ((name (cameraOffset (x y z)) (cameraOrientation (pan tilt)) (intrinsics (fx fy cx cy)) (weight w) (timeout t)) ...) [(%s)]", DEFAULT_SOURCE);
+        yInfo("\t--kp: %f [%f]", kp, DEFAULT_KP);
+        yInfo("\t--kd: %f [%f]", kd, DEFAULT_KD);
+        yInfo("\t--maxVelocity: %f [%f]", maxVelocity, DEFAULT_MAX_VELOCITY);
+        yInfo("\t--trajectoryDuration: %f [%f]", trajectoryDuration, DEFAULT_TRAJECTORY_DURATION);
+        yInfo("\t--alpha: %f [%f]", alpha, DEFAULT_ALPHA);
+        yInfo("\t--beta: %f [%f]", beta, DEFAULT_BETA);
+        yInfo("\t--lookahead: %f [%f]", lookahead, DEFAULT_LOOKAHEAD);
+        yInfo("\t--associationGate: %f [%f]", associationGate, DEFAULT_ASSOCIATION_GATE);
+        yInfo("\t--noPrediction: %d [0]", noPrediction);
+        yInfo("\t--signalThreshold: %f [%f]", signalThreshold, DEFAULT_SIGNAL_THRESHOLD);
+        yInfo("\t--centerThreshold: %f [%f]", centerThreshold, DEFAULT_CENTER_THRESHOLD);
+        return false;
+    }
+
+    if (mode == "step")
+    {
+        trackingMode = tracking_mode::STEP;
+    }
+    else if (mode == "position")
+    {
+        trackingMode = tracking_mode::POSITION;
+    }
+    else if (mode == "velocity")
+    {
+        trackingMode = tracking_mode::VELOCITY;
+    }
+    else if (mode == "direct")
+    {
+        trackingMode = tracking_mode::DIRECT;
+    }
+    else
+    {
+        yError() << "Unsupported tracking mode, please use '--mode step', '--mode position', '--mode velocity' or '--mode direct', got:" << mode;
+        return false;
+    }
+
+    std::array<double, 3> cameraOffset {0.0, 0.0, 0.0};
+
+    if (rf.check("cameraOffset", "position of the camera wrt. the head rotation center [m]"))
+    {
+        const auto * offsets = rf.find("cameraOffset").asList();
+
+        if (!offsets || offsets->size() != cameraOffset.size())
+        {
+            yError() << "Parameter --cameraOffset must be a list of" << cameraOffset.size() << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < cameraOffset.size(); i++)
+        {
+            cameraOffset[i] = offsets->get(i).asFloat64();
+        }
+    }
+
+    std::array<double, 4> intrinsics {0.0, 0.0, 0.0, 0.0};
+
+    if (rf.check("intrinsics", "(fx fy cx cy) of the camera [px]"))
+    {
+        const auto * values = rf.find("intrinsics").asList();
+
+        if (!values || values->size() != intrinsics.size())
+        {
+            yError() << "Parameter --intrinsics must be a list of" << intrinsics.size() << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < intrinsics.size(); i++)
+        {
+            intrinsics[i] = values->get(i).asFloat64();
+        }
+    }
+
+    if (roiScale < 1.0)
+    {
+        yError() << "Region of interest scale must not be lower than 1, got:" << roiScale;
+        return false;
+    }
+
+    if (!configureSources(rf, cameraOffset, intrinsics))
+    {
+        return false;
+    }
+
+    if (period <= 0.0 || !yarp::os::PeriodicThread::setPeriod(period))
+    {
+        yError() << "Invalid control thread period:" << period;
+        return false;
+    }
+
+    if (noPrediction)
+    {
+        // track the last measurement as is
+        alpha = 1.0;
+        beta = 0.0;
+        lookahead = 0.0;
+    }
+
+    if (alpha <= 0.0 || alpha > 1.0 || beta < 0.0 || beta > 2.0)
+    {
+        yError() << "Invalid target filter gains, got alpha:" << alpha << "and beta:" << beta;
+        return false;
+    }
+
+    if (associationGate <= 0.0)
+    {
+        yError() << "Association gate must be positive, got:" << associationGate;
+        return false;
+    }
+
+    tracker = TargetTracker(alpha, beta, associationGate, std::max(TRACK_TIMEOUT, detectionTimeout));
+
+    if (centerThreshold < 0.0 || centerThreshold >= signalThreshold)
+    {
+        // the band between both thresholds provides hysteresis for zone changes
+        yError() << "Center threshold must lie in [0, signal threshold), got:" << centerThreshold;
+        return false;
+    }
+
+    if (maxVelocity <= 0.0)
+    {
+        yError() << "Velocity saturation must be positive, got:" << maxVelocity;
+        return false;
+    }
+
+    if (trajectoryDuration <= 0.0)
+    {
+        yError() << "Trajectory duration must be positive, got:" << trajectoryDuration;
         return false;
     }
 
@@ -45,12 +238,24 @@ bool FollowMeHeadExecution::configure(yarp::os::ResourceFinder &rf)
         return false;
     }
 
-    if (!headDevice.view(iControlMode) || !headDevice.view(iEncoders) || !headDevice.view(iPositionControl))
+    if (!headDevice.view(iControlLimits) || !headDevice.view(iControlMode) || !headDevice.view(iEncodersTimed) ||
+        !headDevice.view(iPositionControl) || !headDevice.view(iPositionDirect) || !headDevice.view(iVelocityControl))
     {
         yError() << "Failed to view head device interfaces";
         return false;
     }
 
+    for (auto i = 0U; i < minLimits.size(); i++)
+    {
+        if (!iControlLimits->getLimits(i, &minLimits[i], &maxLimits[i]) || minLimits[i] >= maxLimits[i])
+        {
+            yError() << "Failed to retrieve valid joint limits of head joint" << i;
+            return false;
+        }
+
+        yInfo() << "Head joint" << i << "limits:" << minLimits[i] << maxLimits[i];
+    }
+
     if (!iControlMode->setControlModes(std::vector(2, VOCAB_CM_POSITION).data()))
     {
         yError() << "Failed to set position control mode";
@@ -75,28 +280,96 @@ bool FollowMeHeadExecution::configure(yarp::os::ResourceFinder &rf)
         return false;
     }
 
-    if (!detectionPort.open(DEFAULT_PREFIX + std::string("/cv/state:i")))
+    for (auto & source : sources)
+    {
+        // only the default source keeps the legacy (x y z) input
+        if (!source->open(DEFAULT_PREFIX + std::string("/") + source->getName(), source->getName() == DEFAULT_SOURCE))
+        {
+            return false;
+        }
+    }
+
+    if (!trackerPort.open(DEFAULT_PREFIX + std::string("/tracker/state:o")))
+    {
+        yError() << "Failed to open tracker state port" << trackerPort.getName();
+        return false;
+    }
+
+    if (!zonePort.open(DEFAULT_PREFIX + std::string("/zone:o")))
+    {
+        yError() << "Failed to open zone event port" << zonePort.getName();
+        return false;
+    }
+
+    if (!eventPort.open(DEFAULT_PREFIX + std::string("/events:o")))
+    {
+        yError() << "Failed to open action event port" << eventPort.getName();
+        return false;
+    }
+
+    egomotionPort.setStrict(); // keep every sample for the orientation history
+
+    if (!egomotionPort.open(DEFAULT_PREFIX + std::string("/egomotion:i")))
+    {
+        yError() << "Failed to open ego-motion port" << egomotionPort.getName();
+        return false;
+    }
+
+    if (!yarp::os::PeriodicThread::start())
     {
-        yError() << "Failed to open detection client port" << detectionPort.getName();
+        yError() << "Failed to start control thread";
         return false;
     }
 
     yarp::os::Wire::yarp().attachAsServer(serverPort);
-    detectionPort.useCallback(*this);
 
     return true;
 }
 
 double FollowMeHeadExecution::getPeriod()
 {
-    return 0.1; // [s]
+    return 0.02; // [s], also the latency of action events
 }
 
 bool FollowMeHeadExecution::updateModule()
 {
-    if (detectionPort.getInputCount() == 0)
+    if (std::none_of(sources.begin(), sources.end(), [](const auto & source) { return source->isConnected(); }))
+    {
+        yDebugThrottle(1.0) << "Waiting for detection sources to be connected to vision...";
+    }
+
+    if (isFollowing)
+    {
+        auto stats = getStatistics();
+
+        yDebugThrottle(5.0) << "Detection frames: received" << stats.receivedFrames << "| dropped" << stats.droppedFrames
+                            << "| superseded" << stats.supersededFrames << "| processed" << stats.processedFrames
+                            << "|| head commands: issued" << stats.issuedCommands << "| coalesced" << stats.coalescedCommands
+                            << "| suppressed" << stats.suppressedCommands;
+    }
+
+    zone_change_t change;
+
+    while (zoneChanges.pop(change))
     {
-        yDebugThrottle(1.0) << "Waiting for" << detectionPort.getName() << "to be connected to vision...";
+        yarp::os::Bottle & b = zonePort.prepare();
+        b.clear();
+        b.addString(change.description);
+        b.addFloat64(change.pan);
+        zonePort.setEnvelope(yarp::os::Stamp(++zoneEvents, change.timestamp));
+        zonePort.writeStrict();
+    }
+
+    pending_event_t pending;
+
+    while (events.pop(pending))
+    {
+        ActionEvent & event = eventPort.prepare();
+        event.timestamp = pending.timestamp;
+        event.action = pending.action == head_action::FOLLOW ? "follow" : "home";
+        event.part = "head";
+        event.status = pending.status;
+        eventPort.writeStrict(); // none may be lost, clients count them
     }
 
     return true;
@@ -105,99 +378,963 @@ bool FollowMeHeadExecution::updateModule()
 bool FollowMeHeadExecution::interruptModule()
 {
     serverPort.interrupt();
-    detectionPort.interrupt();
-    detectionPort.disableCallback();
-    return stop();
+
+    for (auto & source : sources)
+    {
+        source->interrupt();
+    }
+
+    trackerPort.interrupt();
+    zonePort.interrupt();
+    eventPort.interrupt();
+    egomotionPort.interrupt();
+    yarp::os::PeriodicThread::stop();
+    isFollowing = false;
+    return stopHead();
 }
 
 bool FollowMeHeadExecution::close()
 {
+    yarp::os::PeriodicThread::stop();
     serverPort.close();
-    detectionPort.close();
+
+    for (auto & source : sources)
+    {
+        source->close();
+    }
+
+    trackerPort.close();
+    zonePort.close();
+    eventPort.close();
+    egomotionPort.close();
     headDevice.close();
     return true;
 }
 
-void FollowMeHeadExecution::onRead(yarp::os::Bottle & b)
+void FollowMeHeadExecution::run()
 {
+    if (auto command = pendingCommand.exchange(head_command::NONE); command != head_command::NONE)
+    {
+        processCommand(command);
+    }
+
+    if (auto request = pendingTargetRequest.exchange(NO_TARGET_REQUEST); request != NO_TARGET_REQUEST)
+    {
+        processTargetRequest(request);
+    }
+
+    auto now = yarp::os::Time::now();
+
+    if (currentAction == head_action::HOME)
+    {
+        checkHoming(now);
+    }
+
+    std::array<double, 2> position;
+    std::array<double, 2> timestamps;
+    std::array<double, 2> velocity {0.0, 0.0};
+
+    if (!iEncodersTimed->getEncodersTimed(position.data(), timestamps.data()))
+    {
+        yWarningThrottle(1.0) << "Failed to read head encoders";
+        return;
+    }
+
+    auto stateTimestamp = EgoMotion::resolveTime(yarp::os::Time::now(), timestamps[0], MAX_ENCODER_LATENCY);
+
+    if (!iEncodersTimed->getEncoderSpeeds(velocity.data()))
+    {
+        yWarningThrottle(1.0) << "Failed to read head encoder speeds";
+    }
+
+    egoMotion.addHeadSample(stateTimestamp, position);
+    readEgomotion(now);
+
+    // served to RPC clients without touching the device
+    HeadState state;
+    state.panPosition = position[0];
+    state.tiltPosition = position[1];
+    state.panVelocity = velocity[0];
+    state.tiltVelocity = velocity[1];
+    state.timestamp = stateTimestamp;
+    stateMailbox.write(state);
+
+    std::size_t frameCount = 0;
+
+    for (auto i = 0U; i < sources.size(); i++)
+    {
+        if (auto & pending = pendingFrames[frameCount]; sources[i]->readLegacyFrame(pending.frame))
+        {
+            pending.source = i;
+            frameCount++;
+        }
+
+        if (auto & pending = pendingFrames[frameCount]; sources[i]->readFrame(pending.frame))
+        {
+            pending.source = i;
+            frameCount++;
+        }
+    }
+
     if (!isFollowing)
     {
         return;
     }
 
-    if (b.size() != 3)
+    updateZone(position[0], stateTimestamp);
+
+    // fuse all sources in capture order, a slow source may deliver frames older than a fast one
+    std::iota(frameOrder.begin(), frameOrder.begin() + frameCount, 0);
+
+    std::sort(frameOrder.begin(), frameOrder.begin() + frameCount, [this](auto a, auto b)
+              { return pendingFrames[a].frame.timestamp < pendingFrames[b].frame.timestamp; });
+
+    bool hasDetection = false;
+
+    for (auto i = 0U; i < frameCount; i++)
+    {
+        const auto & pending = pendingFrames[frameOrder[i]];
+        sources[pending.source]->lastFrameTime = now;
+        hasDetection |= processFrame(pending.source, pending.frame, now);
+    }
+
+    checkSources(now);
+    tracker.prune(now);
+    publishTargets(now);
+    publishRegionsOfInterest(now, stateTimestamp, position, velocity);
+
+    const auto * followed = tracker.getFollowed();
+
+    if (!followed || now - followed->lastSeen > detectionTimeout)
     {
-        yWarning() << "InCvPort protocol error, expected 3 elements, got" << b.size();
+        isTargetOutOfReach = false;
+
+        if (trackingMode == tracking_mode::VELOCITY && isMoving)
+        {
+            // target lost, don't let the head drift away with the last commanded velocity
+            yDebug() << "No detections received in the last" << detectionTimeout << "seconds, stopping head";
+
+            std::array<double, 2> zero {0.0, 0.0};
+
+            if (!iVelocityControl->velocityMove(zero.data()))
+            {
+                yError() << "Failed to stop head";
+            }
+
+            isMoving = false;
+        }
+        else if (trackingMode == tracking_mode::DIRECT && isMoving)
+        {
+            // let the current segment come smoothly to rest
+            streamTrajectory(now);
+            isMoving = !trajectory.isFinished(now);
+        }
+
         return;
     }
 
-    auto x = b.get(0).asFloat64(); // [m]
-    auto y = b.get(1).asFloat64(); // [m]
-    auto z = b.get(2).asFloat64(); // [m] (depth, unused)
+    // act on where the target is expected to be now (plus actuation latency), not where it was captured
+    auto target = followed->filter.predict(now + lookahead);
+    auto feedForward = followed->filter.getVelocity();
+    auto base = egoMotion.getBaseOrientation(now);
+    auto baseRate = egoMotion.getBaseRate(now, EGOMOTION_RATE_WINDOW);
 
-    if (std::abs(x) > DETECTION_DEADBAND || std::abs(y) > DETECTION_DEADBAND)
+    // back from the world frame to head joint space, this cancels the robot's own rotation
+    for (auto i = 0U; i < target.size(); i++)
     {
-        // On the received frame, positive X is to the right, positive Y is down.
-        // First axis (global Z roll) is positive to the left (frame-wise).
-        // Second axis (global Y pitch) is positive down (frame-wise).
+        target[i] -= base[i];
+        feedForward[i] -= baseRate[i];
+    }
 
-        std::vector<double> target {
-            std::abs(x) > DETECTION_DEADBAND ? std::copysign(RELATIVE_INCREMENT, -x) : 0.0,
-            std::abs(y) > DETECTION_DEADBAND ? std::copysign(RELATIVE_INCREMENT, y) : 0.0
-        };
+    bool outOfReach = false;
 
-        yDebug() << "Detection port got:" << x << y << z << "|| performing relative motion:" << target;
+    for (auto i = 0U; i < target.size(); i++)
+    {
+        // aim at the closest reachable point instead, and don't keep pushing against the limit
+        if (auto clamped = std::clamp(target[i], minLimits[i], maxLimits[i]); clamped != target[i])
+        {
+            target[i] = clamped;
+            feedForward[i] = 0.0;
+            outOfReach = true;
+        }
+    }
 
-        if (!iPositionControl->relativeMove(target.data()))
+    if (outOfReach != isTargetOutOfReach.exchange(outOfReach))
+    {
+        if (outOfReach)
+        {
+            yWarning() << "Target out of reach, holding head at joint limits";
+        }
+        else
         {
-            yError() << "Failed to move head";
+            yInfo() << "Target back within reach";
         }
     }
-    else
+
+    std::array<double, 2> error {target[0] - position[0], target[1] - position[1]};
+
+    for (auto & e : error)
     {
-        yDebug() << "Detection port got (x,y,z):" << x << y << z;
+        if (std::abs(e) <= deadband)
+        {
+            e = 0.0;
+        }
     }
-}
 
-void FollowMeHeadExecution::enableFollowing()
-{
-    yInfo() << "Received start following signal";
-    isFollowing = true;
+    switch (trackingMode)
+    {
+    case tracking_mode::STEP:
+        if (hasDetection)
+        {
+            stepTowards(error, position);
+        }
+        break;
+    case tracking_mode::POSITION:
+        if (error[0] != 0.0 || error[1] != 0.0)
+        {
+            moveTowards(target, position);
+        }
+        break;
+    case tracking_mode::VELOCITY:
+        trackWithVelocity(error, feedForward, now);
+        break;
+    case tracking_mode::DIRECT:
+        streamTowards(target, position, now);
+        break;
+    }
 }
 
-void FollowMeHeadExecution::disableFollowing()
+bool FollowMeHeadExecution::processFrame(int source, const detection_frame_t & frame, double now)
 {
-    yInfo() << "Received stop following signal, moving to home position";
-    isFollowing = false;
+    std::array<double, 2> cameraAtCapture;
+
+    if (frame.count == 0 || !egoMotion.getCameraOrientation(frame.timestamp, cameraAtCapture))
+    {
+        return false;
+    }
+
+    std::array<TargetTracker::measurement_t, MAX_DETECTIONS> measurements;
+    std::array<int, MAX_DETECTIONS> assignedIds;
+    std::array<std::size_t, MAX_DETECTIONS> detectionIndices;
+    std::size_t count = 0;
+    auto & s = *sources[source];
+
+    if (s.lastCaptureTime > 0.0 && frame.timestamp > s.lastCaptureTime)
+    {
+        auto interval = frame.timestamp - s.lastCaptureTime;
+        auto smoothing = s.frameInterval > 0.0 ? FRAME_INTERVAL_SMOOTHING : 1.0;
+        s.frameInterval += smoothing * (interval - s.frameInterval);
+    }
+
+    s.lastCaptureTime = std::max(s.lastCaptureTime, frame.timestamp);
 
-    if (!iPositionControl->positionMove(headZeros.data()))
+    for (auto i = 0U; i < frame.count; i++)
     {
-        yError() << "Failed to perform homing";
+        const auto & [id, x, y, z, confidence, box] = frame.detections[i];
+        std::array<double, 2> bearing;
+
+        if (!s.computeBearing(x, y, z, bearing))
+        {
+            yWarning() << "Invalid detection depth, got (x,y,z):" << x << y << z;
+            continue;
+        }
+
+        // absolute target in the world frame, as seen at capture time
+        detectionIndices[count] = i;
+        measurements[count++] = {{cameraAtCapture[0] + bearing[0], cameraAtCapture[1] + bearing[1]},
+                                  confidence, s.getWeight(), id, source};
+    }
+
+    if (count == 0)
+    {
+        s.addDropped();
+        return false;
     }
+
+    tracker.update(frame.timestamp, measurements.data(), count, assignedIds.data());
+    processedFrames++;
+
+    yDebug() << "Got" << count << "valid detection(s) || latency:" << now - frame.timestamp;
+
+    if (const auto * followed = tracker.getFollowed(); followed)
+    {
+        for (auto i = 0U; i < count; i++)
+        {
+            if (assignedIds[i] == followed->id)
+            {
+                const auto & detection = frame.detections[detectionIndices[i]];
+                s.followedId = followed->id;
+                s.followedDepth = detection.z;
+                s.followedBox = detection.box;
+                publishTrackerState(*followed, measurements[i].bearing, frame.timestamp, now);
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
-double FollowMeHeadExecution::getOrientationAngle()
+bool FollowMeHeadExecution::configureSources(yarp::os::ResourceFinder & rf, const std::array<double, 3> & cameraOffset,
+                                             const std::array<double, 4> & intrinsics)
 {
-    double angle = 0.0;
+    sources.clear();
+
+    if (!rf.check("sources", "detection sources, ((name (key value) ...) ...)"))
+    {
+        // single camera, backwards compatible port names
+        sources.push_back(std::make_unique<DetectionSource>(DEFAULT_SOURCE, isFollowing));
+
+        if (!sources.back()->configure(yarp::os::Bottle(), cameraOffset, intrinsics, DETECTION_TIMEOUT))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        const auto * descriptions = rf.find("sources").asList();
+
+        if (!descriptions || descriptions->size() == 0 || descriptions->size() > MAX_SOURCES)
+        {
+            yError() << "Parameter --sources must be a list of 1 to" << MAX_SOURCES << "elements";
+            return false;
+        }
+
+        for (auto i = 0U; i < descriptions->size(); i++)
+        {
+            const auto & description = descriptions->get(i);
+            auto name = description.isList() ? description.asList()->get(0).asString() : description.asString();
+            auto options = description.isList() ? description.asList()->tail() : yarp::os::Bottle();
+
+            if (name.empty() || std::any_of(sources.begin(), sources.end(), [&name](const auto & s) { return s->getName() == name; }))
+            {
+                yError() << "Detection sources must have unique non-empty names, got:" << description.toString();
+                return false;
+            }
+
+            sources.push_back(std::make_unique<DetectionSource>(name, isFollowing));
 
-    if (!iEncoders->getEncoder(0, &angle))
+            if (!sources.back()->configure(options, cameraOffset, intrinsics, DETECTION_TIMEOUT))
+            {
+                return false;
+            }
+        }
+    }
+
+    detectionTimeout = 0.0;
+
+    for (const auto & source : sources)
     {
-        yError() << "Failed to get head orientation encoder value";
+        detectionTimeout = std::max(detectionTimeout, source->getTimeout());
+        yInfo() << "Detection source" << source->getName() << "|| weight:" << source->getWeight() << "| timeout:" << source->getTimeout();
     }
 
-    return angle;
+    return true;
 }
 
-bool FollowMeHeadExecution::stop()
+void FollowMeHeadExecution::checkSources(double now)
 {
-    yInfo() << "Received stop command";
-    isFollowing = false;
-
-    if (!iPositionControl->stop())
+    // a stalled source is not fatal as long as others keep the tracks alive
+    for (auto & source : sources)
     {
-        yError() << "Failed to stop head";
-        return false;
+        bool isStalled = now - source->lastFrameTime > source->getTimeout() && source->isConnected();
+
+        if (isStalled != source->isStalled)
+        {
+            if (isStalled)
+            {
+                yWarning() << "Detection source" << source->getName() << "stalled, relying on the remaining sources";
+            }
+            else
+            {
+                yInfo() << "Detection source" << source->getName() << "recovered";
+            }
+
+            source->isStalled = isStalled;
+        }
     }
+}
 
+void FollowMeHeadExecution::readEgomotion(double now)
+{
+    while (auto * b = egomotionPort.read(false))
+    {
+        if (b->size() != 2)
+        {
+            yWarningThrottle(1.0) << "Ego-motion protocol error, expected 2 elements, got" << b->size();
+            continue;
+        }
+
+        auto timestamp = now;
+
+        if (yarp::os::Stamp stamp; egomotionPort.getEnvelope(stamp) && stamp.isValid())
+        {
+            timestamp = EgoMotion::resolveTime(now, stamp.getTime(), MAX_EGOMOTION_LATENCY);
+        }
+
+        // (yaw pitch) of the head base, same axes and sign conventions as the head joints, out of order samples are ignored
+        egoMotion.addBaseSample(timestamp, {b->get(0).asFloat64(), b->get(1).asFloat64()});
+    }
+}
+
+void FollowMeHeadExecution::publishTrackerState(const TargetTracker::target_t & target, const TargetTracker::vector_t & measurement,
+                                                double timestamp, double now)
+{
+    if (trackerPort.getOutputCount() == 0)
+    {
+        return;
+    }
+
+    const auto & estimate = target.filter.getPosition();
+    const auto & velocity = target.filter.getVelocity();
+    const auto & residual = target.filter.getResidual();
+
+    // id (latency) (measurement) (estimate) (velocity) (residual), stamped with capture time
+    yarp::os::Bottle & b = trackerPort.prepare();
+    b.clear();
+    b.addInt32(target.id);
+    b.addFloat64(now - timestamp);
+    addVector(b, measurement);
+    addVector(b, estimate);
+    addVector(b, velocity);
+    addVector(b, residual);
+    trackerPort.setEnvelope(yarp::os::Stamp(static_cast<int>(processedFrames), timestamp));
+    trackerPort.write();
+}
+
+void FollowMeHeadExecution::publishTargets(double now)
+{
+    const auto * followed = tracker.getFollowed();
+    auto base = egoMotion.getBaseOrientation(now);
+    targets_snapshot_t snapshot;
+    snapshot.count = 0;
+
+    for (const auto & t : tracker.getTargets())
+    {
+        if (!t.active)
+        {
+            continue;
+        }
+
+        auto position = t.filter.predict(now);
+        const auto & velocity = t.filter.getVelocity();
+        auto & out = snapshot.targets[snapshot.count++];
+
+        out.id = t.id;
+        out.pan = position[0] - base[0]; // head joint space
+        out.tilt = position[1] - base[1];
+        out.panVelocity = velocity[0];
+        out.tiltVelocity = velocity[1];
+        out.confidence = t.confidence;
+        out.lastSeen = t.lastSeen;
+        out.followed = &t == followed;
+    }
+
+    targetsMailbox.write(snapshot);
+}
+
+void FollowMeHeadExecution::publishRegionsOfInterest(double now, double stateTimestamp, const std::array<double, 2> & position,
+                                                     const std::array<double, 2> & velocity)
+{
+    const auto * followed = tracker.getFollowed();
+    auto base = egoMotion.getBaseOrientation(now);
+
+    for (auto & source : sources)
+    {
+        if (!source->hasRegionOfInterestPort())
+        {
+            continue;
+        }
+
+        // the detector needs to know where this source last saw the followed target, and how big it was
+        if (!followed || followed->id != source->followedId || source->followedBox[2] <= 0 || source->followedBox[3] <= 0 ||
+            source->frameInterval <= 0.0 || now - source->lastCaptureTime > source->getTimeout())
+        {
+            if (source->isRegionOfInterestActive)
+            {
+                source->clearRegionOfInterest(now);
+            }
+
+            continue;
+        }
+
+        // capture time of the next frame
+        auto elapsed = std::ceil(std::max(now - source->lastCaptureTime, 0.0) / source->frameInterval);
+        auto next = source->lastCaptureTime + std::max(elapsed, 1.0) * source->frameInterval;
+
+        auto target = followed->filter.predict(next);
+        std::array<double, 2> bearing;
+
+        for (auto i = 0U; i < bearing.size(); i++)
+        {
+            // the head keeps moving at its current pace in the meantime
+            auto head = std::clamp(position[i] + velocity[i] * (next - stateTimestamp), minLimits[i], maxLimits[i]);
+            bearing[i] = target[i] - base[i] - head;
+        }
+
+        std::array<double, 2> center;
+
+        if (!source->projectBearing(bearing, source->followedDepth, center))
+        {
+            continue;
+        }
+
+        auto width = roiScale * source->followedBox[2];
+        auto height = roiScale * source->followedBox[3];
+
+        source->publishRegionOfInterest(next, followed->id, {center[0] - width / 2.0, center[1] - height / 2.0, width, height});
+    }
+}
+
+void FollowMeHeadExecution::processTargetRequest(int request)
+{
+    switch (request)
+    {
+    case SWITCH_TARGET_REQUEST:
+        if (!tracker.switchTarget())
+        {
+            yWarning() << "No target to switch to";
+        }
+        break;
+    case UNLOCK_TARGET_REQUEST:
+        tracker.unlock();
+        break;
+    default:
+        if (!tracker.lock(request))
+        {
+            yWarning() << "Target" << request << "is no longer tracked";
+        }
+        break;
+    }
+
+    if (const auto * followed = tracker.getFollowed(); followed)
+    {
+        yInfo() << "Following target" << followed->id << (tracker.isLocked() ? "(locked)" : "");
+    }
+}
+
+void FollowMeHeadExecution::processCommand(head_command command)
+{
+    switch (command)
+    {
+    case head_command::FOLLOW:
+        if (trackingMode == tracking_mode::VELOCITY)
+        {
+            isMoving = false;
+            setHeadControlMode(VOCAB_CM_VELOCITY);
+        }
+        else if (trackingMode == tracking_mode::DIRECT)
+        {
+            isMoving = false;
+            setHeadControlMode(VOCAB_CM_POSITION_DIRECT);
+        }
+
+        tracker.reset();
+        hasCommandedTarget = false;
+
+        for (auto & source : sources)
+        {
+            source->lastFrameTime = yarp::os::Time::now(); // grace period
+            source->isStalled = false;
+            source->followedId = -1;
+        }
+
+        currentZone = head_zone::UNKNOWN; // announce the current zone again
+        isFollowing = true;
+        endAction(ActionStatus::PREEMPTED, yarp::os::Time::now());
+        beginAction(head_action::FOLLOW, yarp::os::Time::now());
+        break;
+
+    case head_command::HOME:
+        // following is open-ended, it is done once told to stop
+        endAction(currentAction == head_action::FOLLOW ? ActionStatus::FINISHED : ActionStatus::PREEMPTED,
+                  yarp::os::Time::now());
+
+        isFollowing = false;
+        isTargetOutOfReach = false;
+
+        if (trackingMode == tracking_mode::VELOCITY || trackingMode == tracking_mode::DIRECT)
+        {
+            isMoving = false;
+            setHeadControlMode(VOCAB_CM_POSITION);
+        }
+
+        beginAction(head_action::HOME, yarp::os::Time::now());
+
+        if (!iPositionControl->positionMove(headZeros.data()))
+        {
+            yError() << "Failed to perform homing";
+            endAction(ActionStatus::FAILED, yarp::os::Time::now());
+        }
+
+        hasCommandedTarget = false;
+        nextHomingCheck = yarp::os::Time::now() + HOMING_CHECK_PERIOD;
+
+        break;
+
+    case head_command::STOP:
+        isFollowing = false;
+        isTargetOutOfReach = false;
+        stopHead();
+        endAction(ActionStatus::PREEMPTED, yarp::os::Time::now());
+        break;
+
+    case head_command::NONE:
+        break;
+    }
+
+    for (auto & source : sources)
+    {
+        if (!isFollowing && source->isRegionOfInterestActive)
+        {
+            source->clearRegionOfInterest(yarp::os::Time::now());
+        }
+    }
+}
+
+void FollowMeHeadExecution::updateZone(double pan, double timestamp)
+{
+    // Positive pan is to the left. A zone is only left when the opposite threshold is
+    // crossed, hence the band between both thresholds prevents chattering.
+    auto zone = currentZone;
+    const char * description = nullptr;
+
+    if (pan > signalThreshold)
+    {
+        zone = head_zone::LEFT;
+        description = "left";
+    }
+    else if (pan < -signalThreshold)
+    {
+        zone = head_zone::RIGHT;
+        description = "right";
+    }
+    else if (std::abs(pan) < centerThreshold)
+    {
+        zone = head_zone::CENTER;
+        description = "center";
+    }
+
+    if (zone == currentZone)
+    {
+        return;
+    }
+
+    yDebug() << "Head entered" << description << "zone at" << pan << "degrees";
+    currentZone = zone;
+
+    if (!zoneChanges.push({timestamp, description, pan}))
+    {
+        yWarningThrottle(1.0) << "Zone queue full, dropped change to" << description << "zone";
+    }
+}
+
+void FollowMeHeadExecution::checkHoming(double now)
+{
+    if (now < nextHomingCheck)
+    {
+        return;
+    }
+
+    bool motionDone = false;
+
+    if (!iPositionControl->checkMotionDone(&motionDone))
+    {
+        yWarningThrottle(1.0) << "Unable to check motion state of head";
+    }
+
+    if (motionDone)
+    {
+        endAction(ActionStatus::FINISHED, now);
+    }
+    else
+    {
+        nextHomingCheck = now + HOMING_CHECK_PERIOD;
+    }
+}
+
+void FollowMeHeadExecution::beginAction(head_action action, double timestamp)
+{
+    currentAction = action;
+    publishEvent(action, ActionStatus::STARTED, timestamp);
+}
+
+void FollowMeHeadExecution::endAction(ActionStatus status, double timestamp)
+{
+    if (currentAction != head_action::NONE)
+    {
+        publishEvent(currentAction, status, timestamp);
+        currentAction = head_action::NONE;
+    }
+}
+
+void FollowMeHeadExecution::publishEvent(head_action action, ActionStatus status, double timestamp)
+{
+    if (!events.push({timestamp, action, status}))
+    {
+        yWarningThrottle(1.0) << "Event queue full, dropped head action event";
+    }
+}
+
+void FollowMeHeadExecution::stepTowards(const std::array<double, 2> & error, const std::array<double, 2> & position)
+{
+    if (error[0] != 0.0 || error[1] != 0.0)
+    {
+        // absolute rather than relative targets, so that pending steps are replaced instead of stacked
+        moveTowards({
+            position[0] + (error[0] != 0.0 ? std::copysign(RELATIVE_INCREMENT, error[0]) : 0.0),
+            position[1] + (error[1] != 0.0 ? std::copysign(RELATIVE_INCREMENT, error[1]) : 0.0)
+        }, position);
+    }
+}
+
+void FollowMeHeadExecution::moveTowards(const std::array<double, 2> & requested, const std::array<double, 2> & position)
+{
+    std::array<double, 2> target;
+
+    for (auto i = 0U; i < target.size(); i++)
+    {
+        target[i] = std::clamp(requested[i], minLimits[i], maxLimits[i]);
+    }
+
+    // already pinned at a joint limit, the control board would reject (or ignore) the command
+    if (std::abs(target[0] - position[0]) <= deadband && std::abs(target[1] - position[1]) <= deadband)
+    {
+        suppressedCommands++;
+        return;
+    }
+
+    // The head is either still heading to (or already resting at) a target close enough
+    // to the requested one, no need to bother the control board.
+    if (hasCommandedTarget && std::abs(target[0] - commandedTarget[0]) <= deadband
+                           && std::abs(target[1] - commandedTarget[1]) <= deadband)
+    {
+        coalescedCommands++;
+        return;
+    }
+
+    yDebug() << "Performing absolute motion:" << target[0] << target[1];
+
+    if (!iPositionControl->positionMove(target.data()))
+    {
+        yError() << "Failed to move head";
+        return;
+    }
+
+    commandedTarget = target;
+    hasCommandedTarget = true;
+    issuedCommands++;
+}
+
+void FollowMeHeadExecution::streamTowards(const std::array<double, 2> & target, const std::array<double, 2> & position, double timestamp)
+{
+    if (!isMoving)
+    {
+        trajectory.hold(timestamp, position);
+        isMoving = true;
+    }
+
+    const auto & goal = trajectory.getGoal();
+
+    if (std::abs(target[0] - goal[0]) > deadband || std::abs(target[1] - goal[1]) > deadband)
+    {
+        // re-plan from the current reference, not from the encoders, so that the motion stays smooth
+        std::array<double, 2> p, v, a;
+        trajectory.evaluate(timestamp, p, v, a);
+
+        auto distance = std::max(std::abs(target[0] - p[0]), std::abs(target[1] - p[1]));
+        auto duration = std::max(trajectoryDuration, MIN_JERK_PEAK_VELOCITY_RATIO * distance / maxVelocity);
+
+        yDebug() << "Planning minimum-jerk trajectory:" << target[0] << target[1] << "|| duration:" << duration;
+
+        trajectory.plan(timestamp, p, v, a, target, duration);
+        issuedCommands++;
+    }
+
+    streamTrajectory(timestamp);
+}
+
+void FollowMeHeadExecution::streamTrajectory(double timestamp)
+{
+    std::array<double, 2> p, v, a;
+    trajectory.evaluate(timestamp, p, v, a);
+
+    for (auto i = 0U; i < p.size(); i++)
+    {
+        // re-planning from a fast motion may overshoot slightly
+        p[i] = std::clamp(p[i], minLimits[i], maxLimits[i]);
+    }
+
+    if (!iPositionDirect->setPositions(p.data()))
+    {
+        yErrorThrottle(1.0) << "Failed to stream head reference";
+    }
+}
+
+void FollowMeHeadExecution::trackWithVelocity(const std::array<double, 2> & error, const std::array<double, 2> & feedForward, double timestamp)
+{
+    auto dt = timestamp - lastCommandTime;
+    bool hasDerivative = isMoving && dt > 0.0 && dt < DETECTION_TIMEOUT;
+
+    // the target's own motion is fed forward, the PD law only deals with the residual error
+    std::array<double, 2> velocity;
+
+    for (auto i = 0U; i < error.size(); i++)
+    {
+        auto derivative = hasDerivative ? (error[i] - previousError[i]) / dt : 0.0;
+        velocity[i] = std::clamp(feedForward[i] + kp * error[i] + kd * derivative, -maxVelocity, maxVelocity);
+    }
+
+    yDebugThrottle(0.5) << "Performing velocity motion:" << velocity[0] << velocity[1];
+
+    if (!iVelocityControl->velocityMove(velocity.data()))
+    {
+        yError() << "Failed to move head";
+    }
+
+    issuedCommands++;
+
+    previousError = error;
+    lastCommandTime = timestamp;
+    isMoving = true;
+}
+
+bool FollowMeHeadExecution::setHeadControlMode(int mode)
+{
+    std::array<int, 2> modes {mode, mode};
+
+    if (!iControlMode->setControlModes(modes.data()))
+    {
+        yError() << "Failed to set head control mode";
+        return false;
+    }
+
+    return true;
+}
+
+bool FollowMeHeadExecution::stopHead()
+{
+    isMoving = false;
+    hasCommandedTarget = false;
+
+    if (trackingMode == tracking_mode::DIRECT)
+    {
+        return true; // the board holds the last streamed reference
+    }
+
+    if (trackingMode == tracking_mode::VELOCITY ? !iVelocityControl->stop() : !iPositionControl->stop())
+    {
+        yError() << "Failed to stop head";
+        return false;
+    }
+
+    return true;
+}
+
+void FollowMeHeadExecution::enableFollowing()
+{
+    yInfo() << "Received start following signal";
+    pendingCommand = head_command::FOLLOW;
+}
+
+void FollowMeHeadExecution::disableFollowing()
+{
+    yInfo() << "Received stop following signal, moving to home position";
+    pendingCommand = head_command::HOME;
+}
+
+double FollowMeHeadExecution::getOrientationAngle()
+{
+    return getHeadState().panPosition;
+}
+
+HeadState FollowMeHeadExecution::getHeadState()
+{
+    HeadState state;
+    std::lock_guard lock(mailboxMutex);
+
+    if (!stateMailbox.readLatest(state))
+    {
+        yError() << "Head state not available yet";
+    }
+
+    state.targetOutOfReach = isTargetOutOfReach;
+
+    return state;
+}
+
+HeadStatistics FollowMeHeadExecution::getStatistics()
+{
+    HeadStatistics stats;
+    stats.receivedFrames = 0;
+    stats.droppedFrames = 0;
+    stats.supersededFrames = 0;
+
+    for (const auto & source : sources)
+    {
+        stats.receivedFrames += source->getReceived();
+        stats.droppedFrames += source->getDropped();
+        stats.supersededFrames += source->getSuperseded();
+    }
+
+    stats.processedFrames = processedFrames;
+    stats.issuedCommands = issuedCommands;
+    stats.coalescedCommands = coalescedCommands;
+    stats.suppressedCommands = suppressedCommands;
+    return stats;
+}
+
+std::vector<TrackedTarget> FollowMeHeadExecution::listTargets()
+{
+    targets_snapshot_t snapshot;
+    std::lock_guard lock(mailboxMutex);
+
+    if (!targetsMailbox.readLatest(snapshot))
+    {
+        return {};
+    }
+
+    return {snapshot.targets.begin(), snapshot.targets.begin() + snapshot.count};
+}
+
+bool FollowMeHeadExecution::lockTarget(std::int32_t id)
+{
+    auto targets = listTargets();
+
+    if (std::none_of(targets.begin(), targets.end(), [id](const auto & t) { return t.id == id; }))
+    {
+        yWarning() << "Unknown target id:" << id;
+        return false;
+    }
+
+    yInfo() << "Received lock request on target" << id;
+    pendingTargetRequest = id;
+    return true;
+}
+
+bool FollowMeHeadExecution::unlockTarget()
+{
+    yInfo() << "Received unlock target request";
+    pendingTargetRequest = UNLOCK_TARGET_REQUEST;
+    return true;
+}
+
+bool FollowMeHeadExecution::switchTarget()
+{
+    if (listTargets().empty())
+    {
+        yWarning() << "No targets to switch to";
+        return false;
+    }
+
+    yInfo() << "Received switch target request";
+    pendingTargetRequest = SWITCH_TARGET_REQUEST;
+    return true;
+}
+
+bool FollowMeHeadExecution::stop()
+{
+    yInfo() << "Received stop command";
+    pendingCommand = head_command::STOP;
     return true;
 }
@@ -3,20 +3,36 @@
 #ifndef __FOLLOW_ME_HEAD_EXECUTION_HPP__
 #define __FOLLOW_ME_HEAD_EXECUTION_HPP__
 
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <yarp/os/Bottle.h>
 #include <yarp/os/BufferedPort.h>
+#include <yarp/os/PeriodicThread.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/RpcServer.h>
-#include <yarp/os/TypedReaderCallback.h>
 
+#include <yarp/dev/IControlLimits.h>
 #include <yarp/dev/IControlMode.h>
-#include <yarp/dev/IEncoders.h>
+#include <yarp/dev/IEncodersTimed.h>
 #include <yarp/dev/IPositionControl.h>
+#include <yarp/dev/IPositionDirect.h>
+#include <yarp/dev/IVelocityControl.h>
 #include <yarp/dev/PolyDriver.h>
 
+#include "ActionEvent.h"
+#include "DetectionSource.hpp"
+#include "EgoMotion.hpp"
 #include "FollowMeHeadCommands.h"
+#include "LatestValueMailbox.hpp"
+#include "MinJerkTrajectory.hpp"
+#include "RingBuffer.hpp"
+#include "TargetTracker.hpp"
 
 namespace roboticslab
 {
@@ -24,12 +40,22 @@ namespace roboticslab
 /**
  * @ingroup followMeHeadExecution
  * @brief Head Execution Core.
+ *
+ * Detections and RPC commands are handed over to a single periodic control
+ * thread, which is the only one allowed to command the head device. Detections
+ * from several sources are fused into the same set of tracks. Targets are
+ * tracked in a world-fixed frame if the orientation of the head base is streamed
+ * to the ego-motion port, hence the head cancels out the robot's own rotation.
+ * Following and homing are reported as action events when they start and end.
+ * These and zone changes are handed over to the module thread and written from there.
  */
 class FollowMeHeadExecution : public yarp::os::RFModule,
-                              public yarp::os::TypedReaderCallback<yarp::os::Bottle>,
+                              public yarp::os::PeriodicThread,
                               public FollowMeHeadCommands
 {
 public:
+    FollowMeHeadExecution();
+
     ~FollowMeHeadExecution()
     { close(); }
 
@@ -39,23 +65,146 @@ public:
     double getPeriod() override;
     bool updateModule() override;
 
-    void onRead(yarp::os::Bottle & bot) override;
+    void run() override;
 
     void enableFollowing() override;
     void disableFollowing() override;
     double getOrientationAngle() override;
+    HeadState getHeadState() override;
+    HeadStatistics getStatistics() override;
+    std::vector<TrackedTarget> listTargets() override;
+    bool lockTarget(std::int32_t id) override;
+    bool unlockTarget() override;
+    bool switchTarget() override;
     bool stop() override;
 
 private:
+    enum class tracking_mode { STEP, POSITION, VELOCITY, DIRECT };
+    enum class head_command { NONE, FOLLOW, HOME, STOP };
+    enum class head_zone { UNKNOWN, LEFT, CENTER, RIGHT };
+    enum class head_action { NONE, FOLLOW, HOME };
+
+    // special values of pendingTargetRequest, non-negative values are target ids to lock onto
+    enum : int { NO_TARGET_REQUEST = -3, SWITCH_TARGET_REQUEST = -2, UNLOCK_TARGET_REQUEST = -1 };
+
+    static constexpr std::size_t MAX_SOURCES = 8;
+    static constexpr std::size_t MAX_DETECTIONS = DetectionSource::MAX_DETECTIONS;
+    static constexpr std::size_t MAX_EVENTS = 16;
+    static constexpr std::size_t MAX_ZONE_CHANGES = 16;
+
+    using detection_frame_t = DetectionSource::frame_t;
+
+    struct pending_frame_t
+    {
+        int source;
+        detection_frame_t frame;
+    };
+
+    struct pending_event_t
+    {
+        double timestamp; // [s]
+        head_action action;
+        ActionStatus status;
+    };
+
+    struct zone_change_t
+    {
+        double timestamp; // [s]
+        const char * description;
+        double pan; // [deg]
+    };
+
+    struct targets_snapshot_t
+    {
+        std::size_t count;
+        std::array<TrackedTarget, TargetTracker::MAX_TARGETS> targets;
+    };
+
+    bool configureSources(yarp::os::ResourceFinder & rf, const std::array<double, 3> & cameraOffset, const std::array<double, 4> & intrinsics);
+    void checkSources(double now);
+    void processCommand(head_command command);
+    void processTargetRequest(int request);
+    bool processFrame(int source, const detection_frame_t & frame, double now);
+    void readEgomotion(double now);
+    void publishTrackerState(const TargetTracker::target_t & target, const TargetTracker::vector_t & measurement, double timestamp, double now);
+    void publishTargets(double now);
+    void publishRegionsOfInterest(double now, double stateTimestamp, const std::array<double, 2> & position, const std::array<double, 2> & velocity);
+    void updateZone(double pan, double timestamp);
+    void checkHoming(double now);
+    void beginAction(head_action action, double timestamp);
+    void endAction(ActionStatus status, double timestamp);
+    void publishEvent(head_action action, ActionStatus status, double timestamp);
+    void stepTowards(const std::array<double, 2> & error, const std::array<double, 2> & position);
+    void moveTowards(const std::array<double, 2> & target, const std::array<double, 2> & position);
+    void streamTowards(const std::array<double, 2> & target, const std::array<double, 2> & position, double timestamp);
+    void streamTrajectory(double timestamp);
+    void trackWithVelocity(const std::array<double, 2> & error, const std::array<double, 2> & feedForward, double timestamp);
+    bool setHeadControlMode(int mode);
+    bool stopHead();
+
     yarp::os::RpcServer serverPort;
-    yarp::os::BufferedPort<yarp::os::Bottle> detectionPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> trackerPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> zonePort;
+    yarp::os::BufferedPort<yarp::os::Bottle> egomotionPort;
+    yarp::os::BufferedPort<ActionEvent> eventPort;
 
     yarp::dev::PolyDriver headDevice;
+    yarp::dev::IControlLimits * iControlLimits;
     yarp::dev::IControlMode * iControlMode;
-    yarp::dev::IEncoders * iEncoders;
+    yarp::dev::IEncodersTimed * iEncodersTimed;
     yarp::dev::IPositionControl * iPositionControl;
+    yarp::dev::IPositionDirect * iPositionDirect;
+    yarp::dev::IVelocityControl * iVelocityControl;
+
+    tracking_mode trackingMode {tracking_mode::STEP};
+    double deadband;
+    double kp;
+    double kd;
+    double maxVelocity;
+    double lookahead;
+    double detectionTimeout; // [s], slowest source
+    double trajectoryDuration;
+    double roiScale;
+    double signalThreshold;
+    double centerThreshold;
+    std::array<double, 2> minLimits {0.0, 0.0}; // [deg]
+    std::array<double, 2> maxLimits {0.0, 0.0}; // [deg]
+
+    // owned by the control thread
+    TargetTracker tracker;
+    EgoMotion egoMotion;
+    MinJerkTrajectory trajectory;
+    std::array<double, 2> previousError {0.0, 0.0};
+    double lastCommandTime {0.0};
+    std::array<double, 2> commandedTarget {0.0, 0.0};
+    bool hasCommandedTarget {false};
+    bool isMoving {false};
+    head_zone currentZone {head_zone::UNKNOWN};
+    head_action currentAction {head_action::NONE};
+    double nextHomingCheck {0.0};
+    std::array<pending_frame_t, 2 * MAX_SOURCES> pendingFrames;
+    std::array<std::size_t, 2 * MAX_SOURCES> frameOrder;
+
+    // each one shared with its own callback threads
+    std::vector<std::unique_ptr<DetectionSource>> sources;
+
+    // shared with the RPC threads, the mailboxes have a single consumer and handlers may run concurrently
+    LatestValueMailbox<HeadState> stateMailbox;
+    LatestValueMailbox<targets_snapshot_t> targetsMailbox;
+    std::mutex mailboxMutex; // never taken by the control thread
+    std::atomic<head_command> pendingCommand {head_command::NONE};
 
+    // written by the module thread, a stalled client must not block the control thread
+    RingBuffer<pending_event_t, MAX_EVENTS> events;
+    RingBuffer<zone_change_t, MAX_ZONE_CHANGES> zoneChanges;
+    int zoneEvents {0}; // owned by the module thread
+    std::atomic_int pendingTargetRequest {NO_TARGET_REQUEST};
     std::atomic_bool isFollowing {false};
+    std::atomic_bool isTargetOutOfReach {false};
+    std::atomic<std::int64_t> processedFrames {0};
+    std::atomic<std::int64_t> issuedCommands {0};
+    std::atomic<std::int64_t> coalescedCommands {0};
+    std::atomic<std::int64_t> suppressedCommands {0};
 };
 
 } // namespace roboticslab
@@ -0,0 +1,103 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __INTERPOLATION_BUFFER_HPP__
+#define __INTERPOLATION_BUFFER_HPP__
+
+#include <array>
+#include <cstddef>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Fixed-size ring buffer of timestamped samples with linear interpolation.
+ *
+ * Queries outside the stored time span are clamped to the oldest or newest sample.
+ */
+template <std::size_t M, std::size_t N>
+class InterpolationBuffer
+{
+public:
+    using sample_t = std::array<double, M>;
+
+    //! Store a new sample, timestamps are expected to increase monotonically.
+    void push(double timestamp, const sample_t & sample)
+    {
+        head = (head + 1) % N;
+        timestamps[head] = timestamp;
+        samples[head] = sample;
+
+        if (count < N)
+        {
+            count++;
+        }
+    }
+
+    //! Estimate the sample at the given instant, returns false if no samples were stored yet.
+    bool interpolate(double timestamp, sample_t & sample) const
+    {
+        if (count == 0)
+        {
+            return false;
+        }
+
+        auto newer = head;
+
+        for (auto i = 1U; i < count; i++)
+        {
+            auto older = (head + N - i) % N;
+
+            if (timestamps[older] <= timestamp)
+            {
+                auto span = timestamps[newer] - timestamps[older];
+                auto ratio = span > 0.0 ? (timestamp - timestamps[older]) / span : 1.0;
+
+                if (ratio > 1.0)
+                {
+                    ratio = 1.0;
+                }
+
+                for (auto j = 0U; j < M; j++)
+                {
+                    sample[j] = samples[older][j] + ratio * (samples[newer][j] - samples[older][j]);
+                }
+
+                return true;
+            }
+
+            newer = older;
+        }
+
+        sample = samples[newer]; // older than anything we have
+        return true;
+    }
+
+    //! Most recent sample, returns false if no samples were stored yet.
+    bool latest(double & timestamp, sample_t & sample) const
+    {
+        if (count == 0)
+        {
+            return false;
+        }
+
+        timestamp = timestamps[head];
+        sample = samples[head];
+        return true;
+    }
+
+    void clear()
+    {
+        count = 0;
+    }
+
+private:
+    std::array<double, N> timestamps {};
+    std::array<sample_t, N> samples {};
+    std::size_t head {0};
+    std::size_t count {0};
+};
+
+} // namespace roboticslab
+
+#endif // __INTERPOLATION_BUFFER_HPP__
@@ -0,0 +1,90 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __LATEST_VALUE_MAILBOX_HPP__
+#define __LATEST_VALUE_MAILBOX_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Lock-free single-producer, single-consumer mailbox that keeps the latest value only.
+ *
+ * Implemented as a triple buffer: the producer never waits for the consumer, and
+ * values overwritten before the consumer had a chance to read them are counted
+ * as superseded. Several consumers must serialize their reads externally.
+ */
+template <typename T>
+class LatestValueMailbox
+{
+public:
+    //! Publish a new value (producer side), replacing any unread one.
+    void write(const T & value)
+    {
+        slots[back] = value;
+        auto previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+
+        if (previous & FRESH)
+        {
+            superseded.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        back = previous & INDEX;
+    }
+
+    //! Retrieve the latest value if a new one was published since the last read (consumer side).
+    bool read(T & value)
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+        {
+            return false;
+        }
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        value = slots[front];
+        hasValue = true;
+        return true;
+    }
+
+    //! Retrieve the latest value, even if it had already been read (consumer side).
+    bool readLatest(T & value)
+    {
+        if (read(value))
+        {
+            return true;
+        }
+
+        if (!hasValue)
+        {
+            return false;
+        }
+
+        value = slots[front];
+        return true;
+    }
+
+    //! Number of values that were replaced before being read.
+    std::int64_t getSuperseded() const
+    {
+        return superseded.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned int INDEX = 0x3;
+    static constexpr unsigned int FRESH = 0x4;
+
+    std::array<T, 3> slots {};
+    unsigned int back {0};
+    unsigned int front {1};
+    bool hasValue {false};
+    std::atomic_uint middle {2};
+    std::atomic<std::int64_t> superseded {0};
+};
+
+} // namespace roboticslab
+
+#endif // __LATEST_VALUE_MAILBOX_HPP__
@@ -0,0 +1,55 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "MinJerkTrajectory.hpp"
+
+#include <algorithm> // std::clamp
+
+using namespace roboticslab;
+
+void MinJerkTrajectory::hold(double timestamp, const vector_t & position)
+{
+    plan(timestamp, position, {0.0, 0.0}, {0.0, 0.0}, position, 0.0);
+}
+
+void MinJerkTrajectory::plan(double timestamp, const vector_t & position, const vector_t & velocity,
+                             const vector_t & acceleration, const vector_t & goal, double duration)
+{
+    start = timestamp;
+    this->duration = duration;
+    this->goal = goal;
+
+    for (auto i = 0U; i < coeffs.size(); i++)
+    {
+        auto & c = coeffs[i];
+        c = {position[i], velocity[i], acceleration[i] / 2.0, 0.0, 0.0, 0.0};
+
+        if (duration <= 0.0)
+        {
+            c = {goal[i], 0.0, 0.0, 0.0, 0.0, 0.0};
+            continue;
+        }
+
+        // boundary conditions: final velocity and acceleration are zero
+        const auto d = goal[i] - position[i];
+        const auto v = velocity[i] * duration;
+        const auto a = acceleration[i] * duration * duration;
+        const auto t3 = duration * duration * duration;
+
+        c[3] = (20.0 * d - 12.0 * v - 3.0 * a) / (2.0 * t3);
+        c[4] = (-30.0 * d + 16.0 * v + 3.0 * a) / (2.0 * t3 * duration);
+        c[5] = (12.0 * d - 6.0 * v - a) / (2.0 * t3 * duration * duration);
+    }
+}
+
+void MinJerkTrajectory::evaluate(double timestamp, vector_t & position, vector_t & velocity, vector_t & acceleration) const
+{
+    const auto t = std::clamp(timestamp - start, 0.0, duration);
+
+    for (auto i = 0U; i < coeffs.size(); i++)
+    {
+        const auto & c = coeffs[i];
+        position[i] = c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5]))));
+        velocity[i] = c[1] + t * (2.0 * c[2] + t * (3.0 * c[3] + t * (4.0 * c[4] + t * 5.0 * c[5])));
+        acceleration[i] = 2.0 * c[2] + t * (6.0 * c[3] + t * (12.0 * c[4] + t * 20.0 * c[5]));
+    }
+}
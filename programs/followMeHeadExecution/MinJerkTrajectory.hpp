@@ -0,0 +1,49 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __MIN_JERK_TRAJECTORY_HPP__
+#define __MIN_JERK_TRAJECTORY_HPP__
+
+#include <array>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Minimum-jerk (quintic) joint trajectory that can be re-planned on the fly.
+ *
+ * Each segment starts from an arbitrary position, velocity and acceleration and comes
+ * to rest at the goal, hence re-planning from the current state of an ongoing segment
+ * keeps the streamed reference continuous up to the acceleration.
+ */
+class MinJerkTrajectory
+{
+public:
+    using vector_t = std::array<double, 2>;
+
+    //! Stay at rest at the given position.
+    void hold(double timestamp, const vector_t & position);
+
+    //! Start a new segment towards the goal from the given state.
+    void plan(double timestamp, const vector_t & position, const vector_t & velocity, const vector_t & acceleration,
+              const vector_t & goal, double duration);
+
+    //! Sample the trajectory at the given instant, clamped to the segment bounds.
+    void evaluate(double timestamp, vector_t & position, vector_t & velocity, vector_t & acceleration) const;
+
+    bool isFinished(double timestamp) const
+    { return timestamp >= start + duration; }
+
+    const vector_t & getGoal() const
+    { return goal; }
+
+private:
+    double start {0.0};
+    double duration {0.0};
+    vector_t goal {0.0, 0.0};
+    std::array<std::array<double, 6>, 2> coeffs {};
+};
+
+} // namespace roboticslab
+
+#endif // __MIN_JERK_TRAJECTORY_HPP__
@@ -0,0 +1,65 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __RING_BUFFER_HPP__
+#define __RING_BUFFER_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Bounded lock-free FIFO queue, single producer and single consumer.
+ *
+ * Unlike LatestValueMailbox, every value is kept until read. The producer never
+ * waits for the consumer, it is told instead when the buffer is full. Storage is
+ * preallocated.
+ */
+template <typename T, std::size_t N>
+class RingBuffer
+{
+    static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    //! Append a value (producer side), returns false if the buffer is full.
+    bool push(const T & value)
+    {
+        auto position = tail.load(std::memory_order_relaxed);
+
+        if (position - head.load(std::memory_order_acquire) == N)
+        {
+            return false;
+        }
+
+        slots[position & (N - 1)] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Retrieve the oldest value (consumer side), returns false if the buffer is empty.
+    bool pop(T & value)
+    {
+        auto position = head.load(std::memory_order_relaxed);
+
+        if (position == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = slots[position & (N - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, N> slots;
+    alignas(64) std::atomic<std::size_t> tail {0};
+    alignas(64) std::atomic<std::size_t> head {0};
+};
+
+} // namespace roboticslab
+
+#endif // __RING_BUFFER_HPP__
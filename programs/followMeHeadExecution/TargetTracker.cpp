@@ -0,0 +1,304 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include "TargetTracker.hpp"
+
+#include <cmath> // std::hypot
+
+#include <algorithm> // std::max, std::min
+
+using namespace roboticslab;
+
+namespace
+{
+    double distance(const TargetTracker::vector_t & a, const TargetTracker::vector_t & b)
+    {
+        return std::hypot(a[0] - b[0], a[1] - b[1]);
+    }
+}
+
+void TargetTracker::reset()
+{
+    for (auto & t : targets)
+    {
+        t.active = false;
+    }
+
+    followedId = -1;
+    locked = false;
+    hasLastFollowedBearing = false;
+}
+
+void TargetTracker::update(double timestamp, const measurement_t * measurements, std::size_t count, int * assignedIds)
+{
+    count = std::min(count, MAX_TARGETS);
+
+    std::array<int, MAX_TARGETS> assignment; // measurement index -> target slot
+    std::array<bool, MAX_TARGETS> taken {};
+    std::array<vector_t, MAX_TARGETS> predictions;
+
+    assignment.fill(-1);
+
+    for (auto j = 0U; j < targets.size(); j++)
+    {
+        if (targets[j].active)
+        {
+            predictions[j] = targets[j].filter.predict(timestamp);
+        }
+    }
+
+    // trust the detector's own tracking, if any
+    for (auto i = 0U; i < count; i++)
+    {
+        if (measurements[i].detectorId < 0)
+        {
+            continue;
+        }
+
+        for (auto j = 0U; j < targets.size(); j++)
+        {
+            if (targets[j].active && !taken[j] && targets[j].detectorId == measurements[i].detectorId &&
+                targets[j].detectorSource == measurements[i].source)
+            {
+                assignment[i] = j;
+                taken[j] = true;
+                break;
+            }
+        }
+    }
+
+    // greedy global nearest neighbour within the gate on the remaining pairs
+    while (true)
+    {
+        auto best = gate;
+        int bestMeasurement = -1;
+        int bestTarget = -1;
+
+        for (auto i = 0U; i < count; i++)
+        {
+            if (assignment[i] >= 0)
+            {
+                continue;
+            }
+
+            for (auto j = 0U; j < targets.size(); j++)
+            {
+                if (targets[j].active && !taken[j])
+                {
+                    if (auto d = distance(predictions[j], measurements[i].bearing); d < best)
+                    {
+                        best = d;
+                        bestMeasurement = i;
+                        bestTarget = j;
+                    }
+                }
+            }
+        }
+
+        if (bestMeasurement < 0)
+        {
+            break;
+        }
+
+        assignment[bestMeasurement] = bestTarget;
+        taken[bestTarget] = true;
+    }
+
+    for (auto i = 0U; i < count; i++)
+    {
+        const auto & m = measurements[i];
+        target_t * t = nullptr;
+
+        if (assignment[i] >= 0)
+        {
+            t = &targets[assignment[i]];
+        }
+        else
+        {
+            // spawn a new track in the first free slot, if any
+            for (auto & candidate : targets)
+            {
+                if (!candidate.active)
+                {
+                    t = &candidate;
+                    t->active = true;
+                    t->id = nextId++;
+                    t->detectorId = -1; // the slot may have belonged to a dead track
+                    t->detectorSource = -1;
+                    t->confidence = 0.0;
+                    t->lastSeen = timestamp;
+                    t->filter = AlphaBetaFilter(alpha, beta);
+                    break;
+                }
+            }
+        }
+
+        if (!t)
+        {
+            assignedIds[i] = -1;
+            continue;
+        }
+
+        t->filter.update(timestamp, m.bearing, m.weight);
+        t->lastSeen = std::max(t->lastSeen, timestamp);
+        t->confidence = m.confidence;
+
+        if (m.detectorId >= 0)
+        {
+            // keep the last known id while other sources without own tracking chime in
+            t->detectorId = m.detectorId;
+            t->detectorSource = m.source;
+        }
+
+        assignedIds[i] = t->id;
+    }
+
+    if (!getFollowed())
+    {
+        selectFollowed();
+    }
+}
+
+void TargetTracker::prune(double now)
+{
+    for (auto & t : targets)
+    {
+        if (t.active && now - t.lastSeen > timeout)
+        {
+            t.active = false;
+
+            if (t.id == followedId)
+            {
+                lastFollowedBearing = t.filter.predict(now);
+                hasLastFollowedBearing = true;
+                followedId = -1;
+            }
+        }
+    }
+
+    if (followedId < 0)
+    {
+        selectFollowed();
+    }
+}
+
+bool TargetTracker::lock(int id)
+{
+    if (!find(id))
+    {
+        return false;
+    }
+
+    followedId = id;
+    locked = true;
+    return true;
+}
+
+void TargetTracker::unlock()
+{
+    locked = false;
+
+    if (followedId < 0)
+    {
+        selectFollowed();
+    }
+}
+
+bool TargetTracker::switchTarget()
+{
+    const target_t * next = nullptr;
+    const target_t * first = nullptr;
+
+    for (const auto & t : targets)
+    {
+        if (!t.active)
+        {
+            continue;
+        }
+
+        if (t.id > followedId && (!next || t.id < next->id))
+        {
+            next = &t;
+        }
+
+        if (!first || t.id < first->id)
+        {
+            first = &t;
+        }
+    }
+
+    if (!next)
+    {
+        next = first; // wrap around
+    }
+
+    return next && lock(next->id);
+}
+
+const TargetTracker::target_t * TargetTracker::getFollowed() const
+{
+    for (const auto & t : targets)
+    {
+        if (t.active && t.id == followedId)
+        {
+            return &t;
+        }
+    }
+
+    return nullptr;
+}
+
+TargetTracker::target_t * TargetTracker::find(int id)
+{
+    for (auto & t : targets)
+    {
+        if (t.active && t.id == id)
+        {
+            return &t;
+        }
+    }
+
+    return nullptr;
+}
+
+void TargetTracker::selectFollowed()
+{
+    // Prefer whoever is closest to where the previous target was lost, a locked
+    // target may only be re-acquired in its vicinity. Otherwise, pick the most
+    // confident detection.
+    const target_t * best = nullptr;
+    double bestScore = 0.0;
+
+    for (const auto & t : targets)
+    {
+        if (!t.active)
+        {
+            continue;
+        }
+
+        double score;
+
+        if (hasLastFollowedBearing)
+        {
+            auto d = distance(t.filter.getPosition(), lastFollowedBearing);
+
+            if (locked && d > gate)
+            {
+                continue;
+            }
+
+            score = -d;
+        }
+        else
+        {
+            score = t.confidence;
+        }
+
+        if (!best || score > bestScore)
+        {
+            best = &t;
+            bestScore = score;
+        }
+    }
+
+    followedId = best ? best->id : -1;
+}
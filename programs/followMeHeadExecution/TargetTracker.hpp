@@ -0,0 +1,101 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#ifndef __TARGET_TRACKER_HPP__
+#define __TARGET_TRACKER_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include "AlphaBetaFilter.hpp"
+
+namespace roboticslab
+{
+
+/**
+ * @ingroup followMeHeadExecution
+ * @brief Multi-target tracker with persistent identifiers and a followed target.
+ *
+ * Measurements are absolute bearings in the world frame. Each frame is associated
+ * to the existing tracks by greedy global nearest-neighbour on the predicted bearing,
+ * detector-provided ids take precedence when available. Measurements from several
+ * sources are fused by feeding them in capture order, weighted by the trust in each
+ * source. Storage is preallocated.
+ */
+class TargetTracker
+{
+public:
+    static constexpr std::size_t MAX_TARGETS = 16;
+
+    using vector_t = AlphaBetaFilter::vector_t;
+
+    struct measurement_t
+    {
+        vector_t bearing; // [deg]
+        double confidence;
+        double weight; // trust in the source, in (0, 1]
+        int detectorId; // negative if not provided
+        int source; // detector ids are only meaningful within the same source
+    };
+
+    struct target_t
+    {
+        bool active {false};
+        int id {-1};
+        int detectorId {-1};
+        int detectorSource {-1};
+        double confidence {0.0};
+        double lastSeen {0.0}; // [s]
+        AlphaBetaFilter filter;
+    };
+
+    TargetTracker(double alpha, double beta, double gate, double timeout)
+        : alpha(alpha), beta(beta), gate(gate), timeout(timeout)
+    {}
+
+    //! Drop all tracks and release the lock.
+    void reset();
+
+    //! Associate measurements captured at the same instant, stores the id assigned to each of them.
+    void update(double timestamp, const measurement_t * measurements, std::size_t count, int * assignedIds);
+
+    //! Drop tracks that were not seen for a while, re-select the followed target if needed.
+    void prune(double now);
+
+    //! Follow the given target until it disappears.
+    bool lock(int id);
+
+    //! Go back to automatic selection of the followed target.
+    void unlock();
+
+    //! Lock onto the next active target (in id order).
+    bool switchTarget();
+
+    //! Currently followed target, or nullptr if none.
+    const target_t * getFollowed() const;
+
+    bool isLocked() const
+    { return locked; }
+
+    const std::array<target_t, MAX_TARGETS> & getTargets() const
+    { return targets; }
+
+private:
+    target_t * find(int id);
+    void selectFollowed();
+
+    double alpha;
+    double beta;
+    double gate;
+    double timeout;
+
+    std::array<target_t, MAX_TARGETS> targets;
+    int nextId {0};
+    int followedId {-1};
+    bool locked {false};
+    vector_t lastFollowedBearing {0.0, 0.0};
+    bool hasLastFollowedBearing {false};
+};
+
+} // namespace roboticslab
+
+#endif // __TARGET_TRACKER_HPP__
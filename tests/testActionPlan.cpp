@@ -0,0 +1,133 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "ActionPlan.hpp"
+
+using namespace roboticslab;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using channel = ActionPlan::channel;
+    using sync = ActionPlan::sync;
+
+    // synthetic clock, no test ever waits
+    const auto T0 = ActionPlan::clock::time_point(10s);
+}
+
+TEST(ActionPlanTest, AnchorsAndDelays)
+{
+    ActionPlan plan;
+    auto hello = plan.add(channel::SPEECH, "hello");
+    auto wave = plan.add(channel::ARMS, "greet", hello, sync::AFTER_START, 200ms);
+    auto look = plan.add(channel::HEAD, "center", hello, sync::AFTER_END);
+    auto bye = plan.add(channel::SPEECH, "bye", look, sync::AFTER_END, 1s);
+
+    ASSERT_FALSE(plan.isDone());
+    ASSERT_EQ(plan.nextDue(T0, false), ActionPlan::NONE); // not started yet
+
+    plan.start(T0);
+    ASSERT_EQ(plan.nextDue(T0, false), hello);
+    ASSERT_EQ(plan.nextDeadline(5s, false), T0);
+    ASSERT_EQ(plan.nextDue(T0, true), ActionPlan::NONE); // someone else is talking
+
+    plan.markStarted(hello, T0);
+    ASSERT_EQ(plan.nextDue(T0 + 199ms, true), ActionPlan::NONE);
+    ASSERT_EQ(plan.nextDeadline(5s, true), T0 + 200ms);
+    ASSERT_EQ(plan.nextDue(T0 + 200ms, true), wave);
+
+    // launched late, the gesture's own deadline counts from then on
+    plan.markStarted(wave, T0 + 250ms);
+    ASSERT_EQ(plan.nextDue(T0 + 250ms, true), ActionPlan::NONE);
+    ASSERT_EQ(plan.nextDeadline(5s, true), T0 + 5250ms);
+
+    plan.markDone(hello, T0 + 2s);
+    ASSERT_EQ(plan.nextDue(T0 + 2s, false), look);
+    plan.markStarted(look, T0 + 2s);
+    plan.markDone(look, T0 + 2500ms);
+
+    ASSERT_EQ(plan.nextDue(T0 + 3s, false), ActionPlan::NONE);
+    ASSERT_EQ(plan.nextDue(T0 + 3500ms, true), ActionPlan::NONE);
+    ASSERT_EQ(plan.nextDue(T0 + 3500ms, false), bye);
+
+    plan.markStarted(bye, T0 + 3500ms);
+    plan.markDone(bye, T0 + 4s);
+    ASSERT_FALSE(plan.isDone()); // still waving
+    plan.markDone(wave, T0 + 4s);
+    plan.markDone(wave, T0 + 4s); // reported twice, counted once
+    ASSERT_TRUE(plan.isDone());
+    ASSERT_EQ(plan.nextDeadline(5s, false), ActionPlan::clock::time_point::max());
+}
+
+TEST(ActionPlanTest, OpenEndedStepIsDoneOnStart)
+{
+    ActionPlan plan;
+    auto follow = plan.add(channel::HEAD, "follow", ActionPlan::NONE, sync::AFTER_START, {}, true);
+    auto ok = plan.add(channel::SPEECH, "okay", follow, sync::AFTER_END);
+
+    plan.start(T0);
+    plan.markStarted(follow, T0);
+    ASSERT_EQ(plan.nextDue(T0, false), ok);
+    ASSERT_EQ(plan.findExpired(T0 + 1h), ActionPlan::NONE);
+
+    plan.markStarted(ok, T0);
+    plan.markDone(ok, T0 + 1s);
+    ASSERT_TRUE(plan.isDone());
+}
+
+TEST(ActionPlanTest, EventsCountParts)
+{
+    ActionPlan plan;
+    auto wave = plan.add(channel::ARMS, "greet");
+    auto look = plan.add(channel::HEAD, "greet");
+    plan.start(T0);
+    plan.markStarted(wave, T0);
+    plan.markStarted(look, T0);
+
+    // a late end of the previous request, nothing had started yet
+    plan.processEvent(channel::ARMS, "greet", false, T0);
+
+    // both arms take part, in any order
+    plan.processEvent(channel::ARMS, "greet", true, T0 + 10ms);
+    plan.processEvent(channel::ARMS, "greet", true, T0 + 20ms);
+    plan.processEvent(channel::ARMS, "greet", false, T0 + 1s);
+    plan.processEvent(channel::ARMS, "signal", false, T0 + 1s); // some other action
+    ASSERT_EQ(plan.findExpired(T0 + 1ms), wave); // neither is done
+
+    plan.processEvent(channel::ARMS, "greet", false, T0 + 2s);
+    ASSERT_EQ(plan.findExpired(T0 + 1ms), look); // same action on another channel
+
+    plan.processEvent(channel::HEAD, "greet", true, T0 + 10ms);
+    plan.processEvent(channel::HEAD, "greet", false, T0 + 3s);
+    ASSERT_TRUE(plan.isDone());
+}
+
+TEST(ActionPlanTest, FindExpired)
+{
+    ActionPlan plan;
+    auto hello = plan.add(channel::SPEECH, "hello");
+    auto wave = plan.add(channel::ARMS, "greet", hello, sync::AFTER_START, 500ms);
+    auto look = plan.add(channel::HEAD, "center");
+    plan.start(T0);
+
+    plan.markStarted(hello, T0);
+    plan.markStarted(look, T0 + 100ms);
+    plan.markStarted(wave, T0 + 500ms);
+
+    // speech is tracked by its owner, the others expire in launch order
+    ASSERT_EQ(plan.findExpired(T0 + 100ms), ActionPlan::NONE);
+    ASSERT_EQ(plan.findExpired(T0 + 101ms), look);
+    ASSERT_EQ(plan.nextDeadline(10s, false), T0 + 10100ms);
+
+    plan.markDone(look, T0 + 1s);
+    ASSERT_EQ(plan.findExpired(T0 + 400ms), ActionPlan::NONE);
+    ASSERT_EQ(plan.findExpired(T0 + 501ms), wave);
+    ASSERT_EQ(plan.nextDeadline(10s, false), T0 + 10500ms);
+
+    plan.clear();
+    ASSERT_TRUE(plan.isDone());
+    ASSERT_EQ(plan.findExpired(T0 + 1h), ActionPlan::NONE);
+}
@@ -0,0 +1,109 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <cmath> // std::abs
+
+#include <gtest/gtest.h>
+
+#include "AlphaBetaFilter.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    constexpr auto ALPHA = 0.6;
+    constexpr auto BETA = 0.2;
+    constexpr auto PERIOD = 0.1; // [s], detection rate
+    constexpr auto TOLERANCE = 1e-6;
+
+    // a target walking across the field of view at constant speed
+    AlphaBetaFilter::vector_t bearing(double t)
+    {
+        return {10.0 * t - 20.0, -2.0 * t + 5.0};
+    }
+}
+
+TEST(AlphaBetaFilterTest, FirstMeasurementInitializes)
+{
+    AlphaBetaFilter filter(ALPHA, BETA);
+    ASSERT_FALSE(filter.isInitialized());
+
+    filter.update(1.0, {3.0, -4.0});
+    ASSERT_TRUE(filter.isInitialized());
+    ASSERT_EQ(filter.getTimestamp(), 1.0);
+    ASSERT_EQ(filter.getPosition()[0], 3.0);
+    ASSERT_EQ(filter.getPosition()[1], -4.0);
+    ASSERT_EQ(filter.getVelocity()[0], 0.0);
+
+    // nothing to extrapolate from yet
+    ASSERT_EQ(filter.predict(2.0)[0], 3.0);
+
+    filter.reset();
+    ASSERT_FALSE(filter.isInitialized());
+}
+
+TEST(AlphaBetaFilterTest, ConvergesToConstantVelocity)
+{
+    AlphaBetaFilter filter(ALPHA, BETA);
+
+    for (auto i = 0; i < 200; i++)
+    {
+        filter.update(i * PERIOD, bearing(i * PERIOD));
+    }
+
+    auto last = 199 * PERIOD;
+    ASSERT_NEAR(filter.getPosition()[0], bearing(last)[0], TOLERANCE);
+    ASSERT_NEAR(filter.getPosition()[1], bearing(last)[1], TOLERANCE);
+    ASSERT_NEAR(filter.getVelocity()[0], 10.0, TOLERANCE);
+    ASSERT_NEAR(filter.getVelocity()[1], -2.0, TOLERANCE);
+    ASSERT_NEAR(filter.getResidual()[0], 0.0, TOLERANCE);
+}
+
+TEST(AlphaBetaFilterTest, PredictionCompensatesLatency)
+{
+    constexpr auto LATENCY = 0.25; // [s], capture to actuation
+
+    AlphaBetaFilter filter(ALPHA, BETA);
+
+    for (auto i = 0; i < 200; i++)
+    {
+        filter.update(i * PERIOD, bearing(i * PERIOD));
+    }
+
+    // the detection is stale by the time it is acted upon, the estimate is not
+    auto now = 199 * PERIOD + LATENCY;
+    auto predicted = filter.predict(now);
+    ASSERT_NEAR(predicted[0], bearing(now)[0], TOLERANCE);
+    ASSERT_NEAR(predicted[1], bearing(now)[1], TOLERANCE);
+    ASSERT_GT(std::abs(filter.getPosition()[0] - bearing(now)[0]), 1.0);
+}
+
+TEST(AlphaBetaFilterTest, LateMeasurementKeepsTimestamp)
+{
+    AlphaBetaFilter filter(ALPHA, BETA);
+    filter.update(1.0, {0.0, 0.0});
+    filter.update(1.1, {1.0, 0.0});
+    auto velocity = filter.getVelocity()[0];
+
+    // captured before the last one, yet delivered after it
+    filter.update(1.05, {0.5, 0.0}, 0.5);
+    ASSERT_EQ(filter.getTimestamp(), 1.1);
+    ASSERT_EQ(filter.getVelocity()[0], velocity);
+}
+
+TEST(AlphaBetaFilterTest, WeightScalesCorrection)
+{
+    AlphaBetaFilter full(ALPHA, BETA);
+    AlphaBetaFilter half(ALPHA, BETA);
+
+    for (auto * filter : {&full, &half})
+    {
+        filter->update(0.0, {0.0, 0.0});
+    }
+
+    full.update(PERIOD, {1.0, 0.0}, 1.0);
+    half.update(PERIOD, {1.0, 0.0}, 0.5);
+
+    ASSERT_NEAR(full.getPosition()[0], ALPHA, TOLERANCE);
+    ASSERT_NEAR(half.getPosition()[0], 0.5 * ALPHA, TOLERANCE);
+    ASSERT_NEAR(half.getVelocity()[0], 0.5 * full.getVelocity()[0], TOLERANCE);
+}
@@ -0,0 +1,196 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <cmath>
+
+#include <algorithm>
+#include <functional>
+#include <iterator> // std::size
+
+#include <gtest/gtest.h>
+
+#include "BlendedTrajectory.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    constexpr auto PERIOD = 0.001; // [s]
+    constexpr auto BLEND_TIME = 0.2; // [s]
+    constexpr auto ACCELERATION = 30.0; // [deg/s^2]
+    constexpr auto TOLERANCE = 1e-6;
+    constexpr auto DRIFT_TOLERANCE = ACCELERATION * PERIOD * PERIOD; // samples straddling a blend boundary
+
+    BlendedTrajectory::vector_t single(double value)
+    {
+        BlendedTrajectory::vector_t v {};
+        v[0] = value;
+        return v;
+    }
+
+    struct profile_t
+    {
+        double maxAcceleration {0.0}; // [deg/s^2]
+        double maxVelocity {0.0}; // [deg/s]
+        double maxStep {0.0}; // [deg], per period
+        double maxDrift {0.0}; // [deg], position not matching the integrated velocity
+        BlendedTrajectory::vector_t position;
+        BlendedTrajectory::vector_t velocity;
+    };
+
+    // sample the trajectory at a fixed rate, the callback may append via points before each sample
+    profile_t sample(BlendedTrajectory & trajectory, double start, double end,
+                     const std::function<void(double)> & beforeSample = [](double) {})
+    {
+        profile_t profile;
+        BlendedTrajectory::vector_t position, velocity;
+        beforeSample(start);
+        trajectory.evaluate(start, position, velocity);
+
+        for (auto i = 1; start + i * PERIOD <= end; i++)
+        {
+            auto now = start + i * PERIOD;
+            beforeSample(now);
+
+            BlendedTrajectory::vector_t p, v;
+            trajectory.evaluate(now, p, v);
+
+            for (auto j = 0U; j < BlendedTrajectory::MAX_JOINTS; j++)
+            {
+                auto integrated = position[j] + (velocity[j] + v[j]) * PERIOD / 2.0;
+                profile.maxAcceleration = std::max(profile.maxAcceleration, std::abs(v[j] - velocity[j]) / PERIOD);
+                profile.maxVelocity = std::max(profile.maxVelocity, std::abs(v[j]));
+                profile.maxStep = std::max(profile.maxStep, std::abs(p[j] - position[j]));
+                profile.maxDrift = std::max(profile.maxDrift, std::abs(p[j] - integrated));
+            }
+
+            position = p;
+            velocity = v;
+        }
+
+        profile.position = position;
+        profile.velocity = velocity;
+        return profile;
+    }
+}
+
+TEST(BlendedTrajectoryTest, ShortReversalsHonorAccelerationLimit)
+{
+    BlendedTrajectory trajectory(BLEND_TIME, ACCELERATION);
+    trajectory.reset(0.0, single(0.0));
+
+    const double waypoints[] = {20.0, -20.0, 20.0, 0.0};
+    auto next = 0U;
+
+    auto profile = sample(trajectory, 0.0, 20.0, [&](double now)
+    {
+        while (next < std::size(waypoints) && trajectory.canAppend(now))
+        {
+            ASSERT_TRUE(trajectory.append(now, single(waypoints[next++]), 30.0));
+        }
+    });
+
+    ASSERT_EQ(next, std::size(waypoints));
+    ASSERT_TRUE(trajectory.isFinished(20.0));
+    ASSERT_LE(profile.maxAcceleration, ACCELERATION + TOLERANCE);
+    ASSERT_LE(profile.maxVelocity, 30.0 + TOLERANCE);
+    ASSERT_LE(profile.maxDrift, DRIFT_TOLERANCE);
+    ASSERT_NEAR(profile.position[0], 0.0, TOLERANCE);
+    ASSERT_NEAR(profile.velocity[0], 0.0, TOLERANCE);
+}
+
+TEST(BlendedTrajectoryTest, LateAppendIsContinuous)
+{
+    BlendedTrajectory trajectory(BLEND_TIME, ACCELERATION);
+    trajectory.reset(0.0, single(0.0));
+    ASSERT_TRUE(trajectory.append(0.0, single(20.0), 30.0));
+
+    // last instant at which the final blend has not begun yet
+    auto late = 0.0;
+
+    while (trajectory.canAppend(late + PERIOD))
+    {
+        late += PERIOD;
+    }
+
+    auto isAppended = false;
+
+    auto profile = sample(trajectory, 0.0, 10.0, [&](double now)
+    {
+        if (!isAppended && now >= late - TOLERANCE)
+        {
+            ASSERT_TRUE(trajectory.append(now, single(-20.0), 30.0));
+            isAppended = true;
+        }
+    });
+
+    ASSERT_TRUE(isAppended);
+    ASSERT_LE(profile.maxAcceleration, ACCELERATION + TOLERANCE);
+    ASSERT_LE(profile.maxStep, 30.0 * PERIOD + TOLERANCE);
+    ASSERT_LE(profile.maxDrift, DRIFT_TOLERANCE);
+    ASSERT_NEAR(profile.position[0], -20.0, TOLERANCE);
+}
+
+TEST(BlendedTrajectoryTest, ResetRampsDownFromCurrentVelocity)
+{
+    BlendedTrajectory trajectory(BLEND_TIME, ACCELERATION);
+    trajectory.reset(1.0, single(10.0), single(60.0));
+
+    BlendedTrajectory::vector_t position, velocity;
+    trajectory.evaluate(1.0, position, velocity);
+    ASSERT_NEAR(position[0], 10.0, TOLERANCE);
+    ASSERT_NEAR(velocity[0], 60.0, TOLERANCE);
+    ASSERT_FALSE(trajectory.isFinished(2.0));
+    ASSERT_FALSE(trajectory.canAppend(2.0));
+
+    auto profile = sample(trajectory, 1.0, 4.0);
+
+    // v^2 / 2a further along
+    ASSERT_TRUE(trajectory.isFinished(3.0));
+    ASSERT_LE(profile.maxAcceleration, ACCELERATION + TOLERANCE);
+    ASSERT_LE(profile.maxDrift, DRIFT_TOLERANCE);
+    ASSERT_NEAR(profile.position[0], 70.0, TOLERANCE);
+    ASSERT_NEAR(profile.velocity[0], 0.0, TOLERANCE);
+}
+
+TEST(BlendedTrajectoryTest, PreemptionBlendsOutOfCurrentVelocity)
+{
+    BlendedTrajectory trajectory(BLEND_TIME, ACCELERATION);
+    BlendedTrajectory::vector_t velocity {};
+    velocity[0] = 40.0;
+    velocity[1] = -20.0;
+    trajectory.reset(0.0, single(0.0), velocity);
+
+    // the new target lies behind, hence the arm has to turn around
+    ASSERT_TRUE(trajectory.canAppend(0.0));
+    ASSERT_TRUE(trajectory.append(0.0, single(-10.0), 30.0));
+
+    BlendedTrajectory::vector_t p, v;
+    trajectory.evaluate(0.0, p, v);
+    ASSERT_NEAR(p[0], 0.0, TOLERANCE);
+    ASSERT_NEAR(v[0], 40.0, TOLERANCE);
+    ASSERT_NEAR(v[1], -20.0, TOLERANCE);
+
+    auto profile = sample(trajectory, 0.0, 10.0);
+
+    ASSERT_TRUE(trajectory.isFinished(10.0));
+    ASSERT_LE(profile.maxAcceleration, ACCELERATION + TOLERANCE);
+    ASSERT_LE(profile.maxDrift, DRIFT_TOLERANCE);
+    ASSERT_NEAR(profile.position[0], -10.0, TOLERANCE);
+    ASSERT_NEAR(profile.position[1], 0.0, TOLERANCE);
+}
+
+TEST(BlendedTrajectoryTest, SegmentsHonorVelocityLimits)
+{
+    BlendedTrajectory trajectory(BLEND_TIME, ACCELERATION);
+    BlendedTrajectory::vector_t limits;
+    limits.fill(10.0);
+    trajectory.setMaxVelocities(limits);
+    trajectory.reset(0.0, single(0.0));
+    ASSERT_TRUE(trajectory.append(0.0, single(20.0), 30.0));
+
+    auto profile = sample(trajectory, 0.0, 5.0);
+
+    ASSERT_TRUE(trajectory.isFinished(5.0));
+    ASSERT_LE(profile.maxVelocity, 10.0 + TOLERANCE);
+    ASSERT_NEAR(profile.position[0], 20.0, TOLERANCE);
+}
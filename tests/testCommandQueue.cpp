@@ -0,0 +1,116 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "CommandQueue.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    struct command_t
+    {
+        int producer;
+        int sequence;
+    };
+}
+
+TEST(CommandQueueTest, FifoUpToCapacity)
+{
+    CommandQueue<int, 4> queue;
+    int value;
+
+    ASSERT_FALSE(queue.pop(value));
+
+    for (auto i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.push(i));
+    }
+
+    ASSERT_FALSE(queue.push(4)); // full, nothing overwritten
+
+    for (auto i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(value, i);
+    }
+
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(CommandQueueTest, WrapsAround)
+{
+    CommandQueue<int, 4> queue;
+    int value;
+
+    // never more than three items in flight, the cells are reused many times over
+    for (auto i = 0; i < 100; i++)
+    {
+        ASSERT_TRUE(queue.push(i));
+
+        if (i >= 2)
+        {
+            ASSERT_TRUE(queue.pop(value));
+            ASSERT_EQ(value, i - 2);
+        }
+    }
+
+    for (auto i = 98; i < 100; i++)
+    {
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(value, i);
+    }
+
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(CommandQueueTest, ConcurrentProducers)
+{
+    constexpr auto PRODUCERS = 4;
+    constexpr auto COMMANDS = 10000; // per producer
+
+    CommandQueue<command_t, 64> queue;
+    std::vector<std::thread> producers;
+
+    for (auto p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&queue, p]
+        {
+            for (auto i = 0; i < COMMANDS; i++)
+            {
+                while (!queue.push({p, i}))
+                {
+                    std::this_thread::yield(); // full, wait for the consumer
+                }
+            }
+        });
+    }
+
+    // nothing lost or duplicated, each producer's commands arrive in order
+    std::array<int, PRODUCERS> expected {};
+    auto received = 0;
+    command_t command;
+
+    while (received < PRODUCERS * COMMANDS)
+    {
+        if (!queue.pop(command))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        EXPECT_EQ(command.sequence, expected[command.producer]++); // keep draining, the producers must finish
+        received++;
+    }
+
+    for (auto & producer : producers)
+    {
+        producer.join();
+    }
+
+    ASSERT_FALSE(queue.pop(command));
+}
@@ -0,0 +1,126 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <gtest/gtest.h>
+
+#include "EgoMotion.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    constexpr auto HEAD_PERIOD = 0.01; // [s]
+    constexpr auto BASE_PERIOD = 0.02; // [s]
+    constexpr auto BASE_RATE = 15.0; // [deg/s]
+    constexpr auto HEAD_RATE = -10.0; // [deg/s]
+    constexpr auto TOLERANCE = 1e-9;
+
+    // the robot turns left while the head turns right at a different rate and sampling period
+    void simulate(EgoMotion & egoMotion, double end)
+    {
+        for (auto i = 0; i * HEAD_PERIOD <= end; i++)
+        {
+            auto t = 1.0 + i * HEAD_PERIOD;
+            ASSERT_TRUE(egoMotion.addHeadSample(t, {HEAD_RATE * (t - 1.0), 5.0}));
+        }
+
+        for (auto i = 0; i * BASE_PERIOD <= end; i++)
+        {
+            auto t = 1.0 + i * BASE_PERIOD;
+            ASSERT_TRUE(egoMotion.addBaseSample(t, {BASE_RATE * (t - 1.0), 0.0}));
+        }
+    }
+}
+
+TEST(EgoMotionTest, NoBaseStreamMeansHeadFrame)
+{
+    EgoMotion egoMotion;
+    EgoMotion::vector_t orientation;
+
+    ASSERT_FALSE(egoMotion.getCameraOrientation(1.0, orientation));
+
+    auto base = egoMotion.getBaseOrientation(1.0);
+    ASSERT_EQ(base[0], 0.0);
+    ASSERT_EQ(base[1], 0.0);
+
+    ASSERT_TRUE(egoMotion.addHeadSample(1.0, {10.0, -5.0}));
+    ASSERT_TRUE(egoMotion.getCameraOrientation(1.0, orientation));
+    ASSERT_NEAR(orientation[0], 10.0, TOLERANCE);
+    ASSERT_NEAR(orientation[1], -5.0, TOLERANCE);
+}
+
+TEST(EgoMotionTest, CameraOrientationAtCaptureTime)
+{
+    EgoMotion egoMotion;
+    simulate(egoMotion, 0.5);
+
+    // a capture instant that matches neither stream's samples
+    auto capture = 1.237;
+    EgoMotion::vector_t orientation;
+    ASSERT_TRUE(egoMotion.getCameraOrientation(capture, orientation));
+    ASSERT_NEAR(orientation[0], (BASE_RATE + HEAD_RATE) * (capture - 1.0), TOLERANCE);
+    ASSERT_NEAR(orientation[1], 5.0, TOLERANCE);
+
+    // a static target seen from the camera must keep its world-frame bearing while everything moves
+    constexpr auto TARGET = 20.0; // [deg]
+
+    for (auto t : {1.05, 1.2, 1.333, 1.49})
+    {
+        ASSERT_TRUE(egoMotion.getCameraOrientation(t, orientation));
+        auto bearing = TARGET - (BASE_RATE + HEAD_RATE) * (t - 1.0); // as the detector would report it
+        ASSERT_NEAR(orientation[0] + bearing, TARGET, TOLERANCE);
+
+        // back to head joint space, as the controller does
+        auto head = orientation[0] + bearing - egoMotion.getBaseOrientation(t)[0];
+        ASSERT_NEAR(head, TARGET - BASE_RATE * (t - 1.0), TOLERANCE);
+    }
+}
+
+TEST(EgoMotionTest, BaseRate)
+{
+    EgoMotion egoMotion;
+    simulate(egoMotion, 0.5);
+
+    auto rate = egoMotion.getBaseRate(1.4, 0.1);
+    ASSERT_NEAR(rate[0], BASE_RATE, TOLERANCE);
+    ASSERT_NEAR(rate[1], 0.0, TOLERANCE);
+
+    // the stream is held beyond its last sample, the robot seems to stop
+    rate = egoMotion.getBaseRate(5.0, 0.1);
+    ASSERT_NEAR(rate[0], 0.0, TOLERANCE);
+}
+
+TEST(EgoMotionTest, ClampedOutsideHistory)
+{
+    EgoMotion egoMotion;
+    simulate(egoMotion, 0.5);
+
+    auto base = egoMotion.getBaseOrientation(0.5);
+    ASSERT_NEAR(base[0], 0.0, TOLERANCE);
+
+    base = egoMotion.getBaseOrientation(2.0);
+    ASSERT_NEAR(base[0], BASE_RATE * 0.5, TOLERANCE);
+}
+
+TEST(EgoMotionTest, OutOfOrderSamplesIgnored)
+{
+    EgoMotion egoMotion;
+    ASSERT_TRUE(egoMotion.addBaseSample(1.0, {0.0, 0.0}));
+    ASSERT_TRUE(egoMotion.addBaseSample(1.1, {10.0, 0.0}));
+    ASSERT_FALSE(egoMotion.addBaseSample(1.1, {50.0, 0.0}));
+    ASSERT_FALSE(egoMotion.addBaseSample(1.05, {50.0, 0.0}));
+    ASSERT_NEAR(egoMotion.getBaseOrientation(1.05)[0], 5.0, TOLERANCE);
+
+    ASSERT_TRUE(egoMotion.addHeadSample(1.0, {0.0, 0.0}));
+    ASSERT_FALSE(egoMotion.addHeadSample(0.9, {0.0, 0.0}));
+}
+
+TEST(EgoMotionTest, ResolveTime)
+{
+    constexpr auto MAX_LATENCY = 0.2; // [s]
+
+    ASSERT_EQ(EgoMotion::resolveTime(10.0, 9.9, MAX_LATENCY), 9.9); // plausible
+    ASSERT_EQ(EgoMotion::resolveTime(10.0, 10.0, MAX_LATENCY), 10.0); // no latency at all
+    ASSERT_EQ(EgoMotion::resolveTime(10.0, 10.5, MAX_LATENCY), 10.0); // from the future
+    ASSERT_EQ(EgoMotion::resolveTime(10.0, 5.0, MAX_LATENCY), 10.0); // too old, clocks out of sync
+    ASSERT_EQ(EgoMotion::resolveTime(10.0, 0.0, MAX_LATENCY), 10.0); // unstamped
+}
@@ -0,0 +1,92 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "EventQueue.hpp"
+
+using namespace roboticslab;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using clock = EventQueue<int>::clock;
+}
+
+TEST(EventQueueTest, Fifo)
+{
+    EventQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+
+    int event;
+
+    // pending events are served even if the deadline already passed
+    for (auto expected : {1, 2, 3})
+    {
+        ASSERT_TRUE(queue.pop(event, clock::time_point::min()));
+        ASSERT_EQ(event, expected);
+    }
+
+    ASSERT_FALSE(queue.pop(event, clock::time_point::min()));
+}
+
+TEST(EventQueueTest, Clear)
+{
+    EventQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    queue.clear();
+
+    int event;
+    ASSERT_FALSE(queue.pop(event, clock::time_point::min()));
+
+    queue.push(3);
+    ASSERT_TRUE(queue.pop(event, clock::time_point::min()));
+    ASSERT_EQ(event, 3);
+}
+
+TEST(EventQueueTest, MoveOnlyEvents)
+{
+    EventQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(42));
+
+    std::unique_ptr<int> event;
+    ASSERT_TRUE(queue.pop(event, clock::time_point::min()));
+    ASSERT_EQ(*event, 42);
+}
+
+TEST(EventQueueTest, DeadlineExpires)
+{
+    EventQueue<int> queue;
+    auto deadline = clock::now() + 20ms;
+
+    int event;
+    ASSERT_FALSE(queue.pop(event, deadline));
+    ASSERT_GE(clock::now(), deadline);
+}
+
+TEST(EventQueueTest, PushWakesUpConsumer)
+{
+    EventQueue<int> queue;
+    auto start = clock::now();
+
+    std::thread producer([&queue]
+    {
+        std::this_thread::sleep_for(10ms);
+        queue.push(7);
+    });
+
+    // far away, the consumer must not sleep until then
+    int event;
+    auto isPopped = queue.pop(event, start + 1h);
+    producer.join();
+
+    ASSERT_TRUE(isPopped);
+    ASSERT_EQ(event, 7);
+    ASSERT_LT(clock::now() - start, 10s);
+}
@@ -0,0 +1,112 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <cmath> // std::abs
+
+#include <algorithm> // std::max
+
+#include <gtest/gtest.h>
+
+#include "MinJerkTrajectory.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    constexpr auto PERIOD = 0.005; // [s]
+    constexpr auto TOLERANCE = 1e-9;
+
+    void expectState(const MinJerkTrajectory & trajectory, double t, const MinJerkTrajectory::vector_t & position,
+                     const MinJerkTrajectory::vector_t & velocity, const MinJerkTrajectory::vector_t & acceleration)
+    {
+        MinJerkTrajectory::vector_t p, v, a;
+        trajectory.evaluate(t, p, v, a);
+
+        for (auto i = 0U; i < p.size(); i++)
+        {
+            EXPECT_NEAR(p[i], position[i], TOLERANCE);
+            EXPECT_NEAR(v[i], velocity[i], TOLERANCE);
+            EXPECT_NEAR(a[i], acceleration[i], TOLERANCE);
+        }
+    }
+}
+
+TEST(MinJerkTrajectoryTest, BoundaryConditionsFromRest)
+{
+    MinJerkTrajectory trajectory;
+    trajectory.plan(1.0, {0.0, 10.0}, {0.0, 0.0}, {0.0, 0.0}, {30.0, -10.0}, 2.0);
+
+    expectState(trajectory, 1.0, {0.0, 10.0}, {0.0, 0.0}, {0.0, 0.0});
+    expectState(trajectory, 3.0, {30.0, -10.0}, {0.0, 0.0}, {0.0, 0.0});
+
+    // symmetric profile, peak velocity of 15/8 times the mean one halfway
+    expectState(trajectory, 2.0, {15.0, 0.0}, {1.875 * 15.0, -1.875 * 10.0}, {0.0, 0.0});
+
+    ASSERT_FALSE(trajectory.isFinished(2.999));
+    ASSERT_TRUE(trajectory.isFinished(3.0));
+    ASSERT_EQ(trajectory.getGoal()[0], 30.0);
+}
+
+TEST(MinJerkTrajectoryTest, BoundaryConditionsFromMotion)
+{
+    MinJerkTrajectory trajectory;
+    trajectory.plan(0.0, {5.0, -5.0}, {20.0, -8.0}, {-40.0, 15.0}, {0.0, 0.0}, 1.5);
+
+    expectState(trajectory, 0.0, {5.0, -5.0}, {20.0, -8.0}, {-40.0, 15.0});
+    expectState(trajectory, 1.5, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0});
+}
+
+TEST(MinJerkTrajectoryTest, ClampedOutsideSegment)
+{
+    MinJerkTrajectory trajectory;
+    trajectory.plan(1.0, {0.0, 0.0}, {10.0, 0.0}, {0.0, 0.0}, {20.0, 0.0}, 1.0);
+
+    // the initial state is held before the start, the goal is held at rest after the end
+    expectState(trajectory, 0.5, {0.0, 0.0}, {10.0, 0.0}, {0.0, 0.0});
+    expectState(trajectory, 5.0, {20.0, 0.0}, {0.0, 0.0}, {0.0, 0.0});
+}
+
+TEST(MinJerkTrajectoryTest, HoldStaysAtRest)
+{
+    MinJerkTrajectory trajectory;
+    trajectory.hold(2.0, {7.0, -3.0});
+
+    ASSERT_TRUE(trajectory.isFinished(2.0));
+    expectState(trajectory, 2.0, {7.0, -3.0}, {0.0, 0.0}, {0.0, 0.0});
+    expectState(trajectory, 10.0, {7.0, -3.0}, {0.0, 0.0}, {0.0, 0.0});
+}
+
+TEST(MinJerkTrajectoryTest, ReplanningIsContinuous)
+{
+    MinJerkTrajectory trajectory;
+    trajectory.plan(0.0, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, {40.0, 10.0}, 2.0);
+
+    MinJerkTrajectory::vector_t p, v, a, previous;
+    trajectory.evaluate(0.0, previous, v, a);
+    double maxStep = 0.0;
+
+    for (auto i = 1; i * PERIOD <= 4.0; i++)
+    {
+        auto t = i * PERIOD;
+
+        if (i == 150)
+        {
+            // the target moved the other way, start over from the current state
+            trajectory.evaluate(t, p, v, a);
+            trajectory.plan(t, p, v, a, {-20.0, 10.0}, 2.0);
+        }
+
+        trajectory.evaluate(t, p, v, a);
+
+        for (auto j = 0U; j < p.size(); j++)
+        {
+            maxStep = std::max(maxStep, std::abs(p[j] - previous[j]));
+        }
+
+        previous = p;
+    }
+
+    // no jumps at the re-planning instant, the peak velocity is well below 200 deg/s
+    ASSERT_LT(maxStep, 200.0 * PERIOD);
+    ASSERT_NEAR(p[0], -20.0, TOLERANCE);
+    ASSERT_NEAR(p[1], 10.0, TOLERANCE);
+}
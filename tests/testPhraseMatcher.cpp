@@ -0,0 +1,144 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PhraseMatcher.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    // same ids and phrases as the Spanish language file
+    enum { HI_TEO, FOLLOW_ME, MY_NAME_IS, STOP_FOLLOWING };
+
+    PhraseMatcher spanish()
+    {
+        PhraseMatcher matcher;
+        matcher.addPhrase(HI_TEO, "hola teo");
+        matcher.addPhrase(HI_TEO, "buenos dias teo");
+        matcher.addPhrase(FOLLOW_ME, "sigueme");
+        matcher.addPhrase(FOLLOW_ME, "ven conmigo");
+        matcher.addPhrase(MY_NAME_IS, "me llamo");
+        matcher.addPhrase(MY_NAME_IS, "mi nombre es");
+        matcher.addPhrase(STOP_FOLLOWING, "para teo");
+        matcher.addPhrase(STOP_FOLLOWING, "deja de seguirme");
+        matcher.addPhrase(STOP_FOLLOWING, "quedate aqui");
+        matcher.compile();
+        return matcher;
+    }
+}
+
+TEST(PhraseMatcherTest, Tokenize)
+{
+    auto tokens = PhraseMatcher::tokenize("¡Buenos DÍAS, Teo! ¿Qué tal? Don't");
+    std::vector<std::string> expected {"buenos", "dias", "teo", "que", "tal", "dont"}; // one word
+    ASSERT_EQ(tokens, expected);
+
+    ASSERT_EQ(PhraseMatcher::tokenize("áéíóú ÁÉÍÓÚ ñÑ çÇ àü"), (std::vector<std::string> {"aeiou", "aeiou", "nn", "cc", "au"}));
+    ASSERT_TRUE(PhraseMatcher::tokenize(" ¿?, ").empty());
+}
+
+TEST(PhraseMatcherTest, RejectsInvalidPhrases)
+{
+    PhraseMatcher matcher;
+    ASSERT_TRUE(matcher.addPhrase(0, "Quédate aquí"));
+    ASSERT_FALSE(matcher.addPhrase(1, "quedate aqui")); // same once normalized
+    ASSERT_FALSE(matcher.addPhrase(1, " ¡! "));
+    ASSERT_FALSE(matcher.addPhrase(-1, "hola"));
+}
+
+TEST(PhraseMatcherTest, AccentsAreFolded)
+{
+    auto matcher = spanish();
+
+    auto m = matcher.match("¡Buenos días, Teo!");
+    ASSERT_EQ(m.id, HI_TEO);
+    ASSERT_EQ(m.score, 1.0);
+
+    m = matcher.match("Por favor, quédate aquí.");
+    ASSERT_EQ(m.id, STOP_FOLLOWING);
+    ASSERT_EQ(m.score, 1.0);
+
+    m = matcher.match("SÍGUEME");
+    ASSERT_EQ(m.id, FOLLOW_ME);
+    ASSERT_EQ(m.score, 1.0);
+
+    ASSERT_EQ(matcher.match("no entiendo nada").id, PhraseMatcher::NO_MATCH);
+}
+
+TEST(PhraseMatcherTest, TyposAreTolerated)
+{
+    auto matcher = spanish();
+
+    // one edit in a seven-letter word
+    auto m = matcher.match("sigeme");
+    ASSERT_EQ(m.id, FOLLOW_ME);
+    ASSERT_NEAR(m.score, 1.0 - 1.0 / 7.0, 1e-9);
+
+    // short words must match exactly
+    ASSERT_EQ(matcher.match("vez conmigo").id, PhraseMatcher::NO_MATCH);
+    ASSERT_EQ(matcher.match("para leo").id, PhraseMatcher::NO_MATCH);
+}
+
+TEST(PhraseMatcherTest, ExactWordsBeatReplacements)
+{
+    PhraseMatcher matcher;
+    matcher.addPhrase(0, "izquierda");
+    matcher.addPhrase(1, "izquierdo");
+    matcher.addPhrase(2, "derecha");
+    matcher.compile();
+
+    // one edit away from both, yet spelled exactly like one of them
+    ASSERT_EQ(matcher.match("izquierdo").id, 1);
+    ASSERT_EQ(matcher.match("izquierda").id, 0);
+    ASSERT_EQ(matcher.match("a la derecha").score, 1.0);
+
+    // the replacement is the closest known word
+    auto m = matcher.match("derrecha");
+    ASSERT_EQ(m.id, 2);
+    ASSERT_LT(m.score, 1.0);
+}
+
+TEST(PhraseMatcherTest, PhrasesSharingTheLastWord)
+{
+    PhraseMatcher matcher;
+    matcher.addPhrase(0, "me");
+    matcher.addPhrase(1, "with me");
+    matcher.addPhrase(2, "come with me");
+    matcher.addPhrase(3, "follow me");
+    matcher.addPhrase(4, "call me");
+    matcher.compile();
+
+    // the longest phrase wins, shorter ones are found along the failure links
+    ASSERT_EQ(matcher.match("please come with me").id, 2);
+    ASSERT_EQ(matcher.match("go with me").id, 1);
+    ASSERT_EQ(matcher.match("teo follow me now").id, 3);
+    ASSERT_EQ(matcher.match("just call me pepe").id, 4);
+    ASSERT_EQ(matcher.match("it's me").id, 0);
+
+    // short words must match exactly, an unknown one breaks longer phrases apart
+    ASSERT_EQ(matcher.match("come wth me").id, 0);
+}
+
+TEST(PhraseMatcherTest, MinimumScore)
+{
+    PhraseMatcher matcher;
+    matcher.addPhrase(0, "stop");
+    matcher.addPhrase(1, "stop following");
+    matcher.compile();
+
+    auto m = matcher.match("stop folowing");
+    ASSERT_EQ(m.id, 1);
+    ASSERT_NEAR(m.score, (1.0 + (1.0 - 1.0 / 9.0)) / 2.0, 1e-9);
+
+    // too garbled to trust, fall back to what was clearly heard
+    m = matcher.match("stop folowing", 0.95);
+    ASSERT_EQ(m.id, 0);
+    ASSERT_EQ(m.score, 1.0);
+
+    ASSERT_EQ(matcher.match("folowing", 0.95).id, PhraseMatcher::NO_MATCH);
+    ASSERT_EQ(matcher.match("following", 0.95).id, PhraseMatcher::NO_MATCH); // not a phrase by itself
+}
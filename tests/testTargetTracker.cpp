@@ -0,0 +1,177 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+#include <gtest/gtest.h>
+
+#include "TargetTracker.hpp"
+
+using namespace roboticslab;
+
+namespace
+{
+    constexpr auto ALPHA = 0.6;
+    constexpr auto BETA = 0.2;
+    constexpr auto GATE = 8.0; // [deg]
+    constexpr auto TIMEOUT = 1.0; // [s]
+
+    TargetTracker::measurement_t measure(double pan, double tilt, int detectorId = -1, int source = 0)
+    {
+        return {{pan, tilt}, 1.0, 1.0, detectorId, source};
+    }
+
+    int feed(TargetTracker & tracker, double timestamp, const TargetTracker::measurement_t & measurement)
+    {
+        int id;
+        tracker.update(timestamp, &measurement, 1, &id);
+        return id;
+    }
+}
+
+TEST(TargetTrackerTest, RespawnedSlotForgetsDetectorId)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    // tracked by the detector itself, then lost
+    auto dead = feed(tracker, 0.0, measure(0.0, 0.0, 5, 0));
+    ASSERT_GE(dead, 0);
+    tracker.prune(2.0);
+    ASSERT_EQ(tracker.getFollowed(), nullptr);
+
+    // someone else shows up on a source without own ids, the slot is recycled
+    auto other = feed(tracker, 2.0, measure(30.0, 0.0, -1, 1));
+    ASSERT_GE(other, 0);
+    ASSERT_NE(other, dead);
+    ASSERT_EQ(&tracker.getTargets()[0], tracker.getFollowed());
+    ASSERT_EQ(tracker.getTargets()[0].detectorId, -1);
+
+    // the detector reuses its id far away, this is not the same person
+    auto reused = feed(tracker, 2.1, measure(-30.0, 0.0, 5, 0));
+    ASSERT_GE(reused, 0);
+    ASSERT_NE(reused, other);
+    ASSERT_EQ(tracker.getFollowed()->id, other);
+    ASSERT_NEAR(tracker.getFollowed()->filter.getPosition()[0], 30.0, 1e-9);
+}
+
+TEST(TargetTrackerTest, NearestNeighbourAssociation)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    TargetTracker::measurement_t first[] = {measure(-20.0, 0.0), measure(20.0, 0.0)};
+    int ids[2];
+    tracker.update(0.0, first, 2, ids);
+    ASSERT_NE(ids[0], ids[1]);
+
+    // both moved a bit, reported in reverse order
+    TargetTracker::measurement_t second[] = {measure(22.0, 1.0), measure(-18.0, -1.0)};
+    int next[2];
+    tracker.update(0.1, second, 2, next);
+    ASSERT_EQ(next[0], ids[1]);
+    ASSERT_EQ(next[1], ids[0]);
+
+    // outside the gate of any track, someone new
+    auto newcomer = feed(tracker, 0.2, measure(0.0, 0.0));
+    ASSERT_NE(newcomer, ids[0]);
+    ASSERT_NE(newcomer, ids[1]);
+}
+
+TEST(TargetTrackerTest, DetectorIdTakesPrecedence)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    TargetTracker::measurement_t first[] = {measure(0.0, 0.0, 1), measure(5.0, 0.0, 2)};
+    int ids[2];
+    tracker.update(0.0, first, 2, ids);
+
+    // both got closer to the other's track, the detector knows better
+    TargetTracker::measurement_t second[] = {measure(4.0, 0.0, 1), measure(1.0, 0.0, 2)};
+    int next[2];
+    tracker.update(0.1, second, 2, next);
+    ASSERT_EQ(next[0], ids[0]);
+    ASSERT_EQ(next[1], ids[1]);
+
+    // same id from another source means nothing, nearest neighbour decides
+    ASSERT_EQ(feed(tracker, 0.2, measure(1.0, 0.0, 1, 1)), ids[1]);
+}
+
+TEST(TargetTrackerTest, FollowsMostConfidentTarget)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    TargetTracker::measurement_t measurements[] = {measure(-20.0, 0.0), measure(20.0, 0.0)};
+    measurements[1].confidence = 2.0;
+    int ids[2];
+    tracker.update(0.0, measurements, 2, ids);
+
+    ASSERT_NE(tracker.getFollowed(), nullptr);
+    ASSERT_EQ(tracker.getFollowed()->id, ids[1]);
+    ASSERT_FALSE(tracker.isLocked());
+}
+
+TEST(TargetTrackerTest, LockAndSwitch)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    TargetTracker::measurement_t measurements[] = {measure(-20.0, 0.0), measure(0.0, 0.0), measure(20.0, 0.0)};
+    int ids[3];
+    tracker.update(0.0, measurements, 3, ids);
+
+    ASSERT_FALSE(tracker.lock(ids[2] + 100));
+    ASSERT_FALSE(tracker.isLocked());
+
+    ASSERT_TRUE(tracker.lock(ids[1]));
+    ASSERT_TRUE(tracker.isLocked());
+    ASSERT_EQ(tracker.getFollowed()->id, ids[1]);
+
+    // in id order, then wrap around
+    ASSERT_TRUE(tracker.switchTarget());
+    ASSERT_EQ(tracker.getFollowed()->id, ids[2]);
+    ASSERT_TRUE(tracker.switchTarget());
+    ASSERT_EQ(tracker.getFollowed()->id, ids[0]);
+
+    tracker.unlock();
+    ASSERT_FALSE(tracker.isLocked());
+    ASSERT_EQ(tracker.getFollowed()->id, ids[0]); // kept until lost
+}
+
+TEST(TargetTrackerTest, PruneReacquiresNearLostTarget)
+{
+    TargetTracker tracker(ALPHA, BETA, GATE, TIMEOUT);
+
+    TargetTracker::measurement_t measurements[] = {measure(-20.0, 0.0), measure(10.0, 0.0), measure(40.0, 0.0)};
+    measurements[2].confidence = 5.0;
+    int ids[3];
+    tracker.update(0.0, measurements, 3, ids);
+    ASSERT_TRUE(tracker.lock(ids[0]));
+
+    // only the others keep being seen
+    for (auto t = 0.5; t <= 1.5; t += 0.5)
+    {
+        TargetTracker::measurement_t others[] = {measurements[1], measurements[2]};
+        int next[2];
+        tracker.update(t, others, 2, next);
+        tracker.prune(t);
+    }
+
+    // the locked target timed out, no one is close enough to where it was lost
+    ASSERT_EQ(tracker.getFollowed(), nullptr);
+    ASSERT_TRUE(tracker.isLocked());
+
+    // it shows up again next to where it vanished
+    auto back = feed(tracker, 1.6, measure(-17.0, 0.0));
+    ASSERT_NE(back, ids[0]);
+    ASSERT_EQ(tracker.getFollowed()->id, back);
+
+    // not locked, the closest to the lost one wins over the most confident
+    tracker.reset();
+    tracker.update(2.0, measurements, 3, ids);
+    ASSERT_EQ(tracker.getFollowed()->id, ids[2]);
+
+    TargetTracker::measurement_t others[] = {measure(-20.0, 0.0), measure(12.0, 0.0)};
+    others[0].confidence = 10.0;
+    others[1].confidence = 0.1;
+    int next[2];
+    tracker.update(3.5, others, 2, next);
+    tracker.prune(3.5);
+    ASSERT_FALSE(tracker.isLocked());
+    ASSERT_EQ(tracker.getFollowed()->id, ids[1]);
+    ASSERT_EQ(next[1], ids[1]);
+}